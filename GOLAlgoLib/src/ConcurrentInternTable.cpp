@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "ConcurrentInternTable.h"
+
+namespace gol
+{
+    ConcurrentInternTable::Table::Table(size_t capacity)
+        : Mask(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1)
+        , HomeShift(32 - std::bit_width(Mask))
+        , Slots(std::make_unique<std::atomic<Entry>[]>(Mask + 1))
+    { }
+
+    ConcurrentInternTable::ConcurrentInternTable(size_t capacity)
+    {
+        m_Tables.push_back(std::make_unique<Table>(capacity));
+        m_Current.store(m_Tables.back().get(), std::memory_order_relaxed);
+    }
+
+    ConcurrentInternTable::ConcurrentInternTable(ConcurrentInternTable&& other) noexcept
+        : m_Current(other.m_Current.exchange(nullptr, std::memory_order_relaxed))
+        , m_Tables(std::move(other.m_Tables))
+    { }
+
+    ConcurrentInternTable& ConcurrentInternTable::operator=(ConcurrentInternTable&& other) noexcept
+    {
+        m_Current.store(other.m_Current.exchange(nullptr, std::memory_order_relaxed), std::memory_order_relaxed);
+        m_Tables = std::move(other.m_Tables);
+        return *this;
+    }
+
+    size_t ConcurrentInternTable::size() const
+    {
+        return m_Current.load(std::memory_order_relaxed)->Count.load(std::memory_order_relaxed);
+    }
+
+    size_t ConcurrentInternTable::Capacity() const
+    {
+        return m_Current.load(std::memory_order_relaxed)->Mask + 1;
+    }
+
+    size_t ConcurrentInternTable::MemoryUsage() const
+    {
+        size_t bytes = 0;
+        for (const auto& table : m_Tables)
+            bytes += sizeof(Table) + (table->Mask + 1) * sizeof(std::atomic<Entry>);
+        return bytes;
+    }
+
+    void ConcurrentInternTable::ReleaseRetiredTables()
+    {
+        const auto* current = m_Current.load(std::memory_order_relaxed);
+        std::erase_if(m_Tables, [current](const auto& table) { return table.get() != current; });
+    }
+
+    void ConcurrentInternTable::Place(Table& table, Entry entry)
+    {
+        for (auto index = table.Home(TagOf(entry));; index = (index + 1) & table.Mask)
+        {
+            auto expected = EmptyEntry;
+            if (table.Slots[index].compare_exchange_strong(expected, entry, std::memory_order_release, std::memory_order_relaxed))
+                break;
+        }
+        table.Count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void ConcurrentInternTable::StartResize(Table& table)
+    {
+        if (table.Next.load(std::memory_order_acquire))
+            return;
+
+        // Threads that lose the race drop their table before anyone has seen it
+        auto next = std::make_unique<Table>((table.Mask + 1) * 2);
+        Table* expected = nullptr;
+        if (table.Next.compare_exchange_strong(expected, next.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            std::lock_guard lock { m_TablesMutex };
+            m_Tables.push_back(std::move(next));
+        }
+    }
+
+    ConcurrentInternTable::Table* ConcurrentInternTable::HelpResize(Table& table)
+    {
+        auto* next = table.Next.load(std::memory_order_acquire);
+        const auto chunks = table.ChunkCount();
+        for (auto chunk = table.NextChunk.fetch_add(1, std::memory_order_relaxed); chunk < chunks;
+            chunk = table.NextChunk.fetch_add(1, std::memory_order_relaxed))
+        {
+            const auto end = std::min((chunk + 1) * MigrationChunk, table.Mask + 1);
+            for (auto index = chunk * MigrationChunk; index < end; index++)
+            {
+                // Empty slots are closed so late inserts move on to the next table. Entries are copied
+                // before their slot is marked, so a lookup always finds them in one table or the other.
+                auto& slot = table.Slots[index];
+                auto entry = slot.load(std::memory_order_acquire);
+                while (entry == EmptyEntry && !slot.compare_exchange_weak(entry, MovedEntry, std::memory_order_acq_rel, std::memory_order_acquire))
+                    ;
+                if (entry == EmptyEntry)
+                    continue;
+
+                Place(*next, entry);
+                slot.store(MovedEntry, std::memory_order_release);
+            }
+            table.ChunksDone.fetch_add(1, std::memory_order_release);
+        }
+
+        while (table.ChunksDone.load(std::memory_order_acquire) < chunks)
+            std::this_thread::yield();
+
+        auto* expected = &table;
+        m_Current.compare_exchange_strong(expected, next, std::memory_order_acq_rel, std::memory_order_relaxed);
+        return next;
+    }
+}
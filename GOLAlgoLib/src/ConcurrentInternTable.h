@@ -0,0 +1,238 @@
+#ifndef __ConcurrentInternTable_h__
+#define __ConcurrentInternTable_h__
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace gol
+{
+    // Interns 32-bit ids of objects stored elsewhere, so that equal keys always get the same id. A
+    // slot is one word holding an id and 32 bits of its key's hash, and callers compare the keys
+    // themselves, so a slot can be claimed with a single CAS. Probing is linear.
+    //
+    // Lookups never wait or retry. Inserts claim empty slots with CAS, and an insert that loses the
+    // race to an equal key discards its own id. Once the table is half full, a table twice the size
+    // is started. Every thread that reaches the old table while it is being copied then copies a
+    // chunk of slots itself, so no single insert pays for the whole resize. Old tables are kept
+    // until ReleaseRetiredTables, since slow lookups may still be probing them.
+    //
+    // Erasing, iterating and releasing old tables need the table to themselves.
+    class ConcurrentInternTable
+    {
+    public:
+        using Id = uint32_t;
+
+        // Marks empty and moved slots, so neither id can be stored. Lookups return NoId for missing keys.
+        static constexpr Id NoId = 0;
+        static constexpr Id ReservedId = ~Id { 0 };
+
+        static constexpr size_t DefaultCapacity = 1024;
+    public:
+        explicit ConcurrentInternTable(size_t capacity = DefaultCapacity);
+
+        ConcurrentInternTable(const ConcurrentInternTable&) = delete;
+        ConcurrentInternTable& operator=(const ConcurrentInternTable&) = delete;
+
+        ConcurrentInternTable(ConcurrentInternTable&& other) noexcept;
+        ConcurrentInternTable& operator=(ConcurrentInternTable&& other) noexcept;
+
+        // matches(id) tells whether the object with that id has the key being looked for
+        template <typename Matches>
+        Id Find(uint64_t hash, Matches&& matches) const;
+
+        // Returns the id of the matching object, or creates one with create(). When another thread
+        // inserts an equal key first, the created id is handed to discard(id) and theirs is returned.
+        template <typename Matches, typename Create, typename Discard>
+        Id FindOrInsert(uint64_t hash, Matches&& matches, Create&& create, Discard&& discard);
+
+        template <typename Function>
+        void ForEach(Function&& function) const;
+
+        // Removes every id the predicate returns true for, and returns how many were removed. The
+        // surviving ids are moved to a table sized for them, so erasing can also shrink the table.
+        template <typename Predicate>
+        size_t EraseIf(Predicate&& predicate);
+
+        size_t size() const;
+        size_t Capacity() const;
+
+        // Bytes held by the current table and the retired ones
+        size_t MemoryUsage() const;
+
+        void ReleaseRetiredTables();
+    private:
+        using Entry = uint64_t;
+
+        static constexpr Entry EmptyEntry = 0;
+        static constexpr Entry MovedEntry = ~Entry { 0 };
+
+        // Slots copied by a thread each time it helps a resize
+        static constexpr size_t MigrationChunk = 1024;
+
+        struct Table
+        {
+            explicit Table(size_t capacity);
+
+            size_t Mask;
+            int32_t HomeShift;
+            std::unique_ptr<std::atomic<Entry>[]> Slots;
+            std::atomic<size_t> Count = 0;
+
+            // Set once the table is full enough to be replaced
+            std::atomic<Table*> Next = nullptr;
+            std::atomic<size_t> NextChunk = 0;
+            std::atomic<size_t> ChunksDone = 0;
+
+            size_t Home(uint32_t tag) const { return tag >> HomeShift; }
+            size_t ChunkCount() const { return (Mask + MigrationChunk) / MigrationChunk; }
+        };
+
+        // Fibonacci hashing, so hashes that only differ in their low bits still spread over the table
+        static constexpr uint32_t Tag(uint64_t hash) { return static_cast<uint32_t>((hash * 0x9e3779b97f4a7c15ULL) >> 32); }
+
+        static constexpr Entry MakeEntry(uint32_t tag, Id id) { return (Entry { tag } << 32) | id; }
+        static constexpr uint32_t TagOf(Entry entry) { return static_cast<uint32_t>(entry >> 32); }
+        static constexpr Id IdOf(Entry entry) { return static_cast<Id>(entry); }
+
+        // Only called on a table nobody else can see yet, or on one that is being migrated into
+        static void Place(Table& table, Entry entry);
+
+        void StartResize(Table& table);
+
+        // Copies chunks of the table into its replacement until none are left, waits for the
+        // threads still copying, and returns the replacement
+        Table* HelpResize(Table& table);
+    private:
+        std::atomic<Table*> m_Current = nullptr;
+
+        // Every table that may still be probed, including the current one
+        std::vector<std::unique_ptr<Table>> m_Tables {};
+        std::mutex m_TablesMutex {};
+    };
+
+    template <typename Matches>
+    ConcurrentInternTable::Id ConcurrentInternTable::Find(uint64_t hash, Matches&& matches) const
+    {
+        const auto tag = Tag(hash);
+        const Table* table = m_Current.load(std::memory_order_acquire);
+        auto index = table->Home(tag);
+        while (true)
+        {
+            const auto entry = table->Slots[index].load(std::memory_order_acquire);
+            if (entry == EmptyEntry)
+                return NoId;
+
+            // Entries are copied before their slot is marked, so this one is already in the next table.
+            // Keys further along that are still being copied may be missed, which only sends the
+            // caller down the slower path of FindOrInsert.
+            if (entry == MovedEntry)
+            {
+                table = table->Next.load(std::memory_order_acquire);
+                index = table->Home(tag);
+                continue;
+            }
+
+            if (TagOf(entry) == tag && matches(IdOf(entry)))
+                return IdOf(entry);
+            index = (index + 1) & table->Mask;
+        }
+    }
+
+    template <typename Matches, typename Create, typename Discard>
+    ConcurrentInternTable::Id ConcurrentInternTable::FindOrInsert(
+        uint64_t hash, Matches&& matches, Create&& create, Discard&& discard)
+    {
+        if (const auto found = Find(hash, matches); found != NoId)
+            return found;
+
+        const auto tag = Tag(hash);
+        auto created = NoId;
+        Table* table = m_Current.load(std::memory_order_acquire);
+        while (true)
+        {
+            // Inserting into a table that is being copied could lose the entry, so help finish the copy first
+            if (table->Next.load(std::memory_order_acquire))
+            {
+                table = HelpResize(*table);
+                continue;
+            }
+
+            auto index = table->Home(tag);
+            auto entry = table->Slots[index].load(std::memory_order_acquire);
+            while (entry != MovedEntry)
+            {
+                if (entry == EmptyEntry)
+                {
+                    if (created == NoId)
+                        created = create();
+                    if (table->Slots[index].compare_exchange_strong(
+                        entry, MakeEntry(tag, created), std::memory_order_acq_rel, std::memory_order_acquire))
+                    {
+                        if (table->Count.fetch_add(1, std::memory_order_relaxed) + 1 > (table->Mask + 1) / 2)
+                        {
+                            StartResize(*table);
+                            HelpResize(*table);
+                        }
+                        return created;
+                    }
+
+                    // Another thread took the slot, which may hold the same key
+                    continue;
+                }
+
+                if (TagOf(entry) == tag && matches(IdOf(entry)))
+                {
+                    if (created != NoId)
+                        discard(created);
+                    return IdOf(entry);
+                }
+                index = (index + 1) & table->Mask;
+                entry = table->Slots[index].load(std::memory_order_acquire);
+            }
+        }
+    }
+
+    template <typename Function>
+    void ConcurrentInternTable::ForEach(Function&& function) const
+    {
+        const Table* table = m_Current.load(std::memory_order_relaxed);
+        for (size_t i = 0; i <= table->Mask; i++)
+        {
+            if (const auto entry = table->Slots[i].load(std::memory_order_relaxed); entry != EmptyEntry)
+                function(IdOf(entry));
+        }
+    }
+
+    template <typename Predicate>
+    size_t ConcurrentInternTable::EraseIf(Predicate&& predicate)
+    {
+        const Table* table = m_Current.load(std::memory_order_relaxed);
+        std::vector<Entry> kept {};
+        for (size_t i = 0; i <= table->Mask; i++)
+        {
+            const auto entry = table->Slots[i].load(std::memory_order_relaxed);
+            if (entry != EmptyEntry && !predicate(IdOf(entry)))
+                kept.push_back(entry);
+        }
+
+        const auto erased = table->Count.load(std::memory_order_relaxed) - kept.size();
+
+        // A quarter full, so the table can grow back to twice its size before it has to resize
+        auto replacement = std::make_unique<Table>(std::max(DefaultCapacity, kept.size() * 4));
+        for (const auto entry : kept)
+            Place(*replacement, entry);
+
+        m_Current.store(replacement.get(), std::memory_order_relaxed);
+        m_Tables.clear();
+        m_Tables.push_back(std::move(replacement));
+        return erased;
+    }
+}
+
+#endif
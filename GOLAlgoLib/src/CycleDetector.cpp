@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <ranges>
+
+#include "CycleDetector.h"
+#include "LifeHashSet.h"
+
+namespace gol
+{
+	// The splitmix64 finalizer, so neighboring cells get unrelated hashes
+	static constexpr uint64_t MixBits(uint64_t value)
+	{
+		value ^= value >> 30;
+		value *= 0xbf58476d1ce4e5b9ULL;
+		value ^= value >> 27;
+		value *= 0x94d049bb133111ebULL;
+		return value ^ (value >> 31);
+	}
+
+	StateFingerprint CycleDetector::Fingerprint(const LifeHashSet& cells)
+	{
+		StateFingerprint result {};
+		for (const auto& pos : cells)
+		{
+			const auto key = (static_cast<uint64_t>(static_cast<uint32_t>(pos.X)) << 32) | static_cast<uint32_t>(pos.Y);
+			result.Low += MixBits(key);
+			result.High += MixBits(key ^ 0x9e3779b97f4a7c15ULL);
+		}
+		return result;
+	}
+
+	void CycleDetector::Record(int64_t generation, StateFingerprint fingerprint, const LifeHashSet& cells)
+	{
+		Record(generation, fingerprint, [&cells]() -> const LifeHashSet& { return cells; });
+	}
+
+	void CycleDetector::Record(int64_t generation, StateFingerprint fingerprint, const std::function<const LifeHashSet&()>& cells)
+	{
+		if (m_Confirmed)
+			return;
+
+		// A jump can land on a cycle it skipped the start of, so it re-arms the generation by
+		// generation search rather than matching across the gap
+		if (m_History.empty() || generation == m_History.back().Generation + 1)
+			m_Consecutive++;
+		else
+			m_Consecutive = 1;
+
+		// Matches are only taken within MaxPeriod, which also bounds the states a candidate keeps
+		while (!m_History.empty() && m_History.front().Generation < generation - MaxPeriod)
+			m_History.pop_front();
+
+		if (m_CandidatePeriod > 0)
+		{
+			// Jumps skip the generations the cycle would have to be checked against
+			if (generation != m_CycleStart + static_cast<int64_t>(m_States.size()))
+				DropCandidate();
+			else if (static_cast<int64_t>(m_States.size()) == m_CandidatePeriod)
+			{
+				if (cells() == m_States.front())
+				{
+					// A match across a jump can give a multiple of the period, which the kept states
+					// then repeat within. The first repeat is the real period.
+					for (int64_t divisor = 1; divisor < m_CandidatePeriod; divisor++)
+					{
+						if (m_CandidatePeriod % divisor == 0 && m_States[static_cast<size_t>(divisor)] == m_States.front())
+						{
+							m_CandidatePeriod = divisor;
+							m_States.resize(static_cast<size_t>(divisor));
+							break;
+						}
+					}
+					m_Confirmed = true;
+					m_History.clear();
+					return;
+				}
+				DropCandidate();
+			}
+			else
+				m_States.push_back(cells());
+		}
+
+		if (m_CandidatePeriod == 0)
+		{
+			// The newest match gives the shortest period
+			const auto match = std::ranges::find(m_History | std::views::reverse, fingerprint, &Entry::Fingerprint);
+			if (match != std::ranges::rend(m_History))
+			{
+				m_CandidatePeriod = generation - match->Generation;
+				m_CycleStart = generation;
+				m_States.push_back(cells());
+			}
+		}
+
+		m_History.push_back({ generation, fingerprint });
+	}
+
+	std::optional<int64_t> CycleDetector::Period() const
+	{
+		if (!m_Confirmed)
+			return std::nullopt;
+		return m_CandidatePeriod;
+	}
+
+	bool CycleDetector::NeedsEveryGeneration() const
+	{
+		if (m_Confirmed)
+			return false;
+		return m_CandidatePeriod > 0 || m_Consecutive < 2 * MaxPeriod;
+	}
+
+	size_t CycleDetector::KeptStates() const
+	{
+		return m_States.size();
+	}
+
+	const LifeHashSet& CycleDetector::StateAt(int64_t generation) const
+	{
+		return m_States[static_cast<size_t>((generation - m_CycleStart) % m_CandidatePeriod)];
+	}
+
+	void CycleDetector::Reset()
+	{
+		m_History.clear();
+		DropCandidate();
+		m_Consecutive = 0;
+		m_Confirmed = false;
+	}
+
+	void CycleDetector::DropCandidate()
+	{
+		m_CandidatePeriod = 0;
+		m_States.clear();
+	}
+}
@@ -0,0 +1,81 @@
+#ifndef __CycleDetector_h__
+#define __CycleDetector_h__
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "LifeHashSet.h"
+
+namespace gol
+{
+	// 128 bits standing in for a generation. Equal states always have equal fingerprints, but equal
+	// fingerprints only suggest equal states, so the detector confirms every match before using it.
+	struct StateFingerprint
+	{
+		uint64_t Low = 0;
+		uint64_t High = 0;
+
+		bool operator==(const StateFingerprint&) const = default;
+	};
+
+	// Watches the fingerprints of recent generations for a repeat. When generation g matches
+	// generation g - p, the next p generations are kept, and the cycle is confirmed once generation
+	// g + p equals generation g exactly. From then on every generation is one of the kept states.
+	class CycleDetector
+	{
+	public:
+		// Longer periods are not looked for, which bounds both the history and the kept states
+		static constexpr int64_t MaxPeriod = 64;
+
+		// A sum of per-cell hashes, so the order of the set does not matter
+		static StateFingerprint Fingerprint(const LifeHashSet& cells);
+
+		void Record(int64_t generation, StateFingerprint fingerprint, const LifeHashSet& cells);
+
+		// The cells are only read while a match is being checked, for engines that have to build them
+		void Record(int64_t generation, StateFingerprint fingerprint, const std::function<const LifeHashSet&()>& cells);
+
+		// Only set once a cycle has been confirmed
+		std::optional<int64_t> Period() const;
+
+		// A candidate is only confirmed by consecutive generations, and every period up to MaxPeriod is
+		// only looked for once twice that many have been seen in a row, so jumps should wait until then.
+		// A jump starts the count over.
+		bool NeedsEveryGeneration() const;
+
+		// Generations kept for the candidate or confirmed cycle, never more than MaxPeriod
+		size_t KeptStates() const;
+
+		// Cells of any generation from the start of the confirmed cycle on
+		const LifeHashSet& StateAt(int64_t generation) const;
+
+		// Edits break the cycle, so they start the detection over
+		void Reset();
+	private:
+		void DropCandidate();
+	private:
+		struct Entry
+		{
+			int64_t Generation;
+			StateFingerprint Fingerprint;
+		};
+
+		std::deque<Entry> m_History {};
+
+		// Period suggested by a matching fingerprint, and the states seen since the match
+		int64_t m_CandidatePeriod = 0;
+		int64_t m_CycleStart = 0;
+		std::vector<LifeHashSet> m_States {};
+
+		// Generations recorded right after the one before, since the last reset or jump
+		int64_t m_Consecutive = 0;
+
+		bool m_Confirmed = false;
+	};
+}
+
+#endif
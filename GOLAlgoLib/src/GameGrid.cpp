@@ -1,9 +1,10 @@
 #include <algorithm>
+#include <bit>
 #include <cstdint>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <optional>
-#include <set>
 #include <utility>
 #include <vector>
 
@@ -11,19 +12,22 @@
 #include "Graphics2D.h"
 #include "LifeHashSet.h"
 #include "LifeAlgorithm.h"
+#include "ThreadPool.h"
 
-gol::GameGrid::GameGrid(int32_t width, int32_t height)
+gol::GameGrid::GameGrid(int32_t width, int32_t height, LifeAlgorithm algorithm)
 	: m_Width(width), m_Height(height)
-	, m_Algorithm(LifeAlgorithm::SparseLife)
+	, m_Algorithm(algorithm)
 { }
 
-gol::GameGrid::GameGrid(Size2 size)
-	: GameGrid(size.Width, size.Height)
+gol::GameGrid::GameGrid(Size2 size, LifeAlgorithm algorithm)
+	: GameGrid(size.Width, size.Height, algorithm)
 { }
 
 gol::GameGrid::GameGrid(const GameGrid& other, Size2 size)
-	: GameGrid(size)
+	: GameGrid(size, other.m_Algorithm)
 {
+	m_ThreadPool = other.m_ThreadPool;
+	m_Rule = other.m_Rule;
 	m_Population = other.m_Population;
 	for (const auto& pos : other.Data())
 	{
@@ -34,6 +38,8 @@ gol::GameGrid::GameGrid(const GameGrid& other, Size2 size)
 
 bool gol::GameGrid::Dead() const
 {
+	if (m_DataStale)
+		return m_HashTree.Population() == 0;
 	return m_Data.size() == 0;
 }
 
@@ -44,7 +50,7 @@ gol::Rect gol::GameGrid::BoundingBox() const
 
 	auto least = Vec2 { std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::max() };
 	auto most = Vec2  { std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::min() };
-	for (auto&& value : m_Data)
+	for (auto&& value : Data())
 	{
 		least.X = std::min(least.X, value.X);
 		least.Y = std::min(least.Y, value.Y);
@@ -62,13 +68,13 @@ gol::Rect gol::GameGrid::BoundingBox() const
 	};
 }
 
-const std::set<gol::Vec2>& gol::GameGrid::SortedData() const
+const std::vector<gol::Vec2>& gol::GameGrid::SortedData() const
 {
 	if (m_ResetCache)
 	{
-		m_SortedData.clear();
-		for (auto& pos : m_Data)
-			m_SortedData.insert(pos);
+		const auto& data = Data();
+		m_SortedData.assign(data.begin(), data.end());
+		std::ranges::sort(m_SortedData);
 		m_ResetCache = false;
 	}
 	return m_SortedData;
@@ -76,29 +82,192 @@ const std::set<gol::Vec2>& gol::GameGrid::SortedData() const
 
 const gol::LifeHashSet& gol::GameGrid::Data() const
 {
+	SyncData();
 	return m_Data;
 }
 
+void gol::GameGrid::SyncData() const
+{
+	if (!m_DataStale)
+		return;
+	m_Data = LifeHashSet { m_HashTree.begin(), m_HashTree.end() };
+	m_DataStale = false;
+}
+
+void gol::GameGrid::InvalidateEngineState()
+{
+	// The tree may be the only copy of the cells
+	SyncData();
+	m_HashTreeStale = true;
+	InvalidateEngineStateExceptHashTree();
+}
+
+void gol::GameGrid::InvalidateEngineStateExceptHashTree()
+{
+	m_TilesStale = true;
+	m_ResetCache = true;
+	m_Cycle.Reset();
+}
+
+void gol::GameGrid::InvalidateSteppedState()
+{
+	m_DataStale = false;
+	m_HashTreeStale = true;
+	m_TilesStale = true;
+	m_ResetCache = true;
+}
+
+void gol::GameGrid::InvalidateAllButHashTree()
+{
+	m_DataStale = true;
+	m_HashTreeStale = false;
+	m_TilesStale = true;
+	m_ResetCache = true;
+}
+
+void gol::GameGrid::SetAlgorithm(LifeAlgorithm algorithm)
+{
+	m_Algorithm = algorithm;
+	InvalidateEngineState();
+}
+
+gol::LifeAlgorithm gol::GameGrid::PreferredAlgorithm(Size2 size)
+{
+	const bool bounded = size.Width > 0 && size.Height > 0;
+	return bounded ? LifeAlgorithm::SparseLife : LifeAlgorithm::HashLife;
+}
+
+void gol::GameGrid::SetRule(const LifeRule& rule)
+{
+	if (rule == m_Rule)
+		return;
+
+	m_Rule = rule;
+	m_Cycle.Reset();
+}
+
+void gol::GameGrid::SetThreadCount(uint32_t threadCount)
+{
+	if (threadCount == ThreadCount())
+		return;
+
+	if (threadCount <= 1)
+		m_ThreadPool.reset();
+	else
+		m_ThreadPool = std::make_shared<ThreadPool>(threadCount);
+}
+
 void gol::GameGrid::Update()
 {
+	if (m_Cycle.Period())
+	{
+		FastForwardCycle(1);
+		return;
+	}
+
 	switch (m_Algorithm) {
 	case LifeAlgorithm::SparseLife:
-		m_Data = SparseLife(m_Data, {0, 0, m_Width, m_Height});
+		m_Data = SparseLife(Data(), {0, 0, m_Width, m_Height}, m_Rule);
+		InvalidateSteppedState();
 		break;
 	case LifeAlgorithm::HashLife:
+		if (m_HashTreeStale)
+			m_HashTree = HashQuadtree { m_Data };
+		m_HashTree.SetRule(m_Rule);
+		HashLife(m_HashTree, {0, 0, m_Width, m_Height}, m_ThreadPool.get());
+		InvalidateAllButHashTree();
+		break;
+	case LifeAlgorithm::TileLife:
+		if (m_TilesStale)
+			m_Tiles = LifeTileMap { Data() };
+		m_Tiles.SetRule(m_Rule);
+		TileLife(m_Tiles, {0, 0, m_Width, m_Height}, m_ThreadPool.get());
+		m_Data = LifeHashSet { m_Tiles.begin(), m_Tiles.end() };
+		InvalidateSteppedState();
+		m_TilesStale = false;
+		break;
+	case LifeAlgorithm::SweepLife:
+		// The sweep already produces the sorted cache, so only the hash set is rebuilt
+		m_SortedData = SweepLife(SortedData(), {0, 0, m_Width, m_Height}, m_Rule);
+		m_Data = LifeHashSet { m_SortedData.begin(), m_SortedData.end() };
+		InvalidateSteppedState();
+		m_ResetCache = false;
 		break;
 	}
 
-	m_Population = m_Data.size();
+	m_Population = m_Algorithm == LifeAlgorithm::HashLife ? ClampPopulation(m_HashTree.Population()) : static_cast<int64_t>(m_Data.size());
 	m_Generation++;
+	RecordGeneration();
 }
 
+void gol::GameGrid::AdvanceBy(uint64_t generations)
+{
+	// Bounded grids have to be clipped every generation, and the other engines only step one
+	// generation at a time, so only unbounded HashLife grids take the power-of-two jumps. Even
+	// those step singly while the cycle detector still needs every generation.
+	const bool jump = !Bounded() && m_Algorithm == LifeAlgorithm::HashLife;
+	for (; generations > 0; generations--)
+	{
+		if (m_Cycle.Period())
+		{
+			FastForwardCycle(generations);
+			return;
+		}
+		if (jump && generations > 1 && !m_Cycle.NeedsEveryGeneration())
+			break;
+		Update();
+	}
+	if (generations == 0)
+		return;
+
+	if (m_HashTreeStale)
+		m_HashTree = HashQuadtree { m_Data };
+	m_HashTree.SetRule(m_Rule);
+
+	for (int32_t stepLog2 = std::bit_width(generations) - 1; stepLog2 >= 0; stepLog2--)
+	{
+		if (generations & (uint64_t { 1 } << stepLog2))
+			m_HashTree.Advance({}, stepLog2, m_ThreadPool.get());
+	}
+
+	InvalidateAllButHashTree();
+
+	m_Population = ClampPopulation(m_HashTree.Population());
+	m_Generation += static_cast<int64_t>(generations);
+	RecordGeneration();
+}
+
+void gol::GameGrid::RecordGeneration()
+{
+	// Every HashLife step leaves the tree current, and its root is far cheaper to compare than the cells
+	const auto fingerprint = m_Algorithm == LifeAlgorithm::HashLife
+		? StateFingerprint
+		{
+			.Low = m_HashTree.Root() | (static_cast<uint64_t>(m_HashTree.RootLevel()) << 32),
+			.High = HashCombine(static_cast<uint64_t>(m_HashTree.RootOffset().X), static_cast<uint64_t>(m_HashTree.RootOffset().Y))
+		}
+		: CycleDetector::Fingerprint(Data());
+
+	// Cells are only asked for while a cycle is being checked, so HashLife steps do not rebuild them otherwise
+	m_Cycle.Record(m_Generation, fingerprint, [this]() -> const LifeHashSet& { return Data(); });
+}
+
+void gol::GameGrid::FastForwardCycle(uint64_t generations)
+{
+	m_Generation += static_cast<int64_t>(generations);
+	m_Data = m_Cycle.StateAt(m_Generation);
+	InvalidateSteppedState();
+	m_Population = static_cast<int64_t>(m_Data.size());
+}
+
+
+
 bool gol::GameGrid::Toggle(int32_t x, int32_t y)
 {
 	if (!InBounds(x, y))
 		return false;
 
-	return Set(x, y, m_Data.find({x, y}) != m_Data.end());
+	return Set(x, y, !Data().contains({x, y}));
 }
 
 bool gol::GameGrid::Set(int32_t x, int32_t y, bool active)
@@ -106,19 +275,21 @@ bool gol::GameGrid::Set(int32_t x, int32_t y, bool active)
 	if (!InBounds(x, y))
 		return false;
 
+	SyncData();
 	auto itr = m_Data.find({x, y});
 	if (itr == m_Data.end() && active)
 	{
 		m_Population++;
 		m_Data.insert({ x, y });
-		m_SortedData.insert({ x, y });
 	}
 	else if (itr != m_Data.end() && !active)
 	{
 		m_Population--;
 		m_Data.erase(itr);
-		m_SortedData.erase({x, y});
 	}
+	InvalidateEngineStateExceptHashTree();
+	if (!m_HashTreeStale)
+		m_HashTree.Set({ x, y }, active);
 
 	m_Generation = 0;
 	return true;
@@ -126,26 +297,28 @@ bool gol::GameGrid::Set(int32_t x, int32_t y, bool active)
 
 void gol::GameGrid::TranslateRegion(const Rect& region, Vec2 translation)
 {
+	// Erasing from the dense set moves its last element into the hole, so
+	// iterator-based erasure would skip cells
 	std::vector<Vec2> newCells;
-	auto it = m_Data.begin();
-	while (it != m_Data.end())
+	SyncData();
+	std::erase_if(m_Data, [&](const Vec2& pos)
 	{
-		if (region.InBounds(*it))
-		{
-			newCells.push_back(*it + translation);
-			m_Data.erase(it++);
-			continue;
-		}
-		++it;
-	}
+		if (!region.InBounds(pos))
+			return false;
+		newCells.push_back(pos + translation);
+		return true;
+	});
 	for (auto& pos : newCells)
 		m_Data.insert(pos);
+	InvalidateEngineState();
 }
 
 gol::GameGrid gol::GameGrid::SubRegion(const Rect& region) const
 {
-	auto result = GameGrid { region.Width, region.Height };
-	for (auto&& pos : m_Data)
+	auto result = GameGrid { region.Width, region.Height, m_Algorithm };
+	result.m_ThreadPool = m_ThreadPool;
+	result.m_Rule = m_Rule;
+	for (auto&& pos : Data())
 	{
 		if (region.InBounds(pos))
 		{
@@ -159,7 +332,7 @@ gol::GameGrid gol::GameGrid::SubRegion(const Rect& region) const
 gol::LifeHashSet gol::GameGrid::ReadRegion(const Rect& region) const
 {
 	LifeHashSet result;
-	for (auto&& pos : m_Data)
+	for (auto&& pos : Data())
 	{
 		if (region.InBounds(pos))
 			result.insert(pos);
@@ -167,35 +340,75 @@ gol::LifeHashSet gol::GameGrid::ReadRegion(const Rect& region) const
 	return result;
 }
 
+std::vector<gol::Vec2> gol::GameGrid::CellsIn(const Rect& region) const
+{
+	std::vector<Vec2> result;
+	if (!m_HashTreeStale)
+	{
+		std::ranges::copy(m_HashTree.CellsIn(region), std::back_inserter(result));
+		return result;
+	}
+
+	for (auto&& pos : Data())
+	{
+		if (region.InBounds(pos))
+			result.push_back(pos);
+	}
+	return result;
+}
+
+int64_t gol::GameGrid::PopulationIn(const Rect& region) const
+{
+	if (!m_HashTreeStale)
+		return ClampPopulation(m_HashTree.PopulationIn(region));
+	return std::ranges::count_if(Data(), [&region](const Vec2& pos) { return region.InBounds(pos); });
+}
+
+int64_t gol::GameGrid::ClampPopulation(uint64_t population)
+{
+	return static_cast<int64_t>(std::min<uint64_t>(population, std::numeric_limits<int64_t>::max()));
+}
 
 void gol::GameGrid::ClearRegion(const Rect& region)
 {
+	SyncData();
 	m_Population -= std::erase_if(m_Data, [region](const Vec2& pos) { return region.InBounds(pos); });
 	m_ResetCache = true;
+	InvalidateEngineState();
 }
 
 void gol::GameGrid::ClearData(const std::vector<Vec2>& data, Vec2 offset)
 {
+	std::vector<Vec2> cleared {};
+	cleared.reserve(data.size());
+	SyncData();
 	for (auto& vec : data)
 	{
-		m_Population -= m_Data.erase({ vec.X + offset.X, vec.Y + offset.Y });
+		const auto pos = Vec2 { vec.X + offset.X, vec.Y + offset.Y };
+		m_Population -= m_Data.erase(pos);
+		cleared.push_back(pos);
 	}
-	m_ResetCache = true;
+	InvalidateEngineStateExceptHashTree();
+	if (!m_HashTreeStale)
+		m_HashTree.SetMany(cleared, false);
 }
 
 gol::LifeHashSet gol::GameGrid::InsertGrid(const GameGrid& region, Vec2 pos)
 {
 	gol::LifeHashSet result {};
-	for (auto&& cell : region.m_Data)
+	SyncData();
+	for (auto&& cell : region.Data())
 	{
 		Vec2 offsetPos = { pos.X + cell.X, pos.Y + cell.Y };
 		if (m_Data.find(offsetPos) != m_Data.end())
 			continue;
 		m_Data.insert(offsetPos);
-		m_SortedData.insert(offsetPos);
 		result.insert(offsetPos);
 		m_Population++;
 	}
+	InvalidateEngineStateExceptHashTree();
+	if (!m_HashTreeStale)
+		m_HashTree.SetMany(result.values(), true);
 	return result;
 }
 
@@ -203,7 +416,7 @@ void gol::GameGrid::RotateGrid(bool clockwise)
 {
 	auto center = Vec2F { static_cast<float>(m_Width / 2.f - 0.5f), static_cast<float>(m_Height / 2.f - 0.5f) };
 	gol::LifeHashSet newSet {};
-	for (auto&& cellPos : m_Data)
+	for (auto&& cellPos : Data())
 	{
 		auto offset = Vec2F { static_cast<float>(cellPos.X), static_cast<float>(cellPos.Y) } - center;
 		auto rotated = clockwise
@@ -214,6 +427,7 @@ void gol::GameGrid::RotateGrid(bool clockwise)
 	}
 	std::swap(m_Width, m_Height);
 	m_ResetCache = true;
+	InvalidateEngineState();
 	m_Data = std::move(newSet);
 }
 
@@ -222,7 +436,7 @@ void gol::GameGrid::FlipGrid(bool vertical)
 	LifeHashSet newData;
 	if (!Bounded())
 	{
-		for (const auto& pos : m_Data)
+		for (const auto& pos : Data())
 		{
 			if (vertical)
 				newData.insert({ pos.X, -pos.Y });
@@ -232,7 +446,7 @@ void gol::GameGrid::FlipGrid(bool vertical)
 	}
 	else
 	{
-		for (const auto& pos : m_Data)
+		for (const auto& pos : Data())
 		{
 			if (vertical)
 				newData.insert({ pos.X, m_Height - 1 - pos.Y });
@@ -241,6 +455,7 @@ void gol::GameGrid::FlipGrid(bool vertical)
 		}
 	}
 	m_ResetCache = true;
+	InvalidateEngineState();
 	m_Data = std::move(newData);
 }
 
@@ -253,5 +468,5 @@ std::optional<bool> gol::GameGrid::Get(Vec2 pos) const
 {
 	if (!InBounds(pos))
 		return std::nullopt;
-	return m_Data.find(pos) != m_Data.end();
+	return Data().contains(pos);
 }
\ No newline at end of file
@@ -4,26 +4,35 @@
 #include <cstdint>
 #include <vector>
 #include <unordered_dense.h>
-#include <set>
 #include <memory>
 #include <optional>
 
+#include "CycleDetector.h"
 #include "Graphics2D.h"
+#include "HashQuadtree.h"
 #include "LifeAlgorithm.h"
 #include "LifeHashSet.h"
+#include "LifeRule.h"
+#include "LifeTileMap.h"
+#include "ThreadPool.h"
 
 namespace gol
 {
 	class GameGrid
 	{
 	public:
-		GameGrid(int32_t width = 0, int32_t height = 0);
-		GameGrid(Size2 size);
+		GameGrid(int32_t width = 0, int32_t height = 0, LifeAlgorithm algorithm = LifeAlgorithm::SparseLife);
+		GameGrid(Size2 size, LifeAlgorithm algorithm = LifeAlgorithm::SparseLife);
 
 		GameGrid(const GameGrid& other, Size2 size);
 
 		void Update();
 
+		// Unbounded HashLife grids jump the rest of the way in power-of-two steps once the cycle
+		// detector no longer needs every generation. Every other grid is stepped one generation at a
+		// time by its own engine. Either way a confirmed cycle fast-forwards what is left.
+		void AdvanceBy(uint64_t generations);
+
 		int32_t Width() const { return m_Width; }
 		int32_t Height() const { return m_Height; }
 		
@@ -41,6 +50,24 @@ namespace gol
 
 		bool Dead() const;
 
+		LifeAlgorithm Algorithm() const { return m_Algorithm; }
+		void SetAlgorithm(LifeAlgorithm algorithm);
+
+		// HashLife for unbounded grids, since only they can take AdvanceBy's jumps, and SparseLife
+		// for bounded ones, which are clipped every generation anyway
+		static LifeAlgorithm PreferredAlgorithm(Size2 size);
+
+		const LifeRule& Rule() const { return m_Rule; }
+		void SetRule(const LifeRule& rule);
+
+		// Set once the grid has been seen to repeat. Later generations are then looked up in the
+		// cycle instead of being computed.
+		std::optional<int64_t> DetectedPeriod() const { return m_Cycle.Period(); }
+
+		// Threads used to step TileLife and HashLife grids, counting the caller. Copies of a grid share its pool.
+		uint32_t ThreadCount() const { return m_ThreadPool ? m_ThreadPool->ThreadCount() : 1; }
+		void SetThreadCount(uint32_t threadCount);
+
 		bool Set(int32_t x, int32_t y, bool active);
 		bool Toggle(int32_t x, int32_t y);
 		
@@ -49,6 +76,12 @@ namespace gol
 		GameGrid SubRegion(const Rect& region) const;
 		
 		LifeHashSet ReadRegion(const Rect& region) const;
+
+		// Live cells inside the region. A current HashLife tree only walks the quadrants overlapping it.
+		std::vector<Vec2> CellsIn(const Rect& region) const;
+
+		// Counted from the HashLife tree when it is current, without visiting every cell
+		int64_t PopulationIn(const Rect& region) const;
 		
 		void ClearRegion(const Rect& region);
 		
@@ -63,13 +96,44 @@ namespace gol
 		std::optional<bool> Get(int32_t x, int32_t y) const;
 		std::optional<bool> Get(Vec2 pos) const;
 
-		const std::set<Vec2>& SortedData() const;
+		// Live cells sorted by X, then Y
+		const std::vector<Vec2>& SortedData() const;
 		const LifeHashSet& Data() const;
+	private:
+		void InvalidateEngineState();
+
+		// For edits that are also applied to the HashLife tree directly
+		void InvalidateEngineStateExceptHashTree();
+
+		// Generations replace the cells without editing them, so the cycle history is kept
+		void InvalidateSteppedState();
+
+		// HashLife generations only advance the tree, and the cells are rebuilt from it when next read
+		void InvalidateAllButHashTree();
+		void SyncData() const;
+
+		void RecordGeneration();
+		void FastForwardCycle(uint64_t generations);
+
+		// HashLife populations are unsigned and saturate, so they are clamped to fit
+		static int64_t ClampPopulation(uint64_t population);
 	private:
 		LifeAlgorithm m_Algorithm;
-		LifeHashSet m_Data;
+		LifeRule m_Rule {};
+		mutable LifeHashSet m_Data;
+		mutable bool m_DataStale = false;
+
+		HashQuadtree m_HashTree;
+		bool m_HashTreeStale = true;
+
+		LifeTileMap m_Tiles;
+		bool m_TilesStale = true;
+
+		std::shared_ptr<ThreadPool> m_ThreadPool;
+
+		CycleDetector m_Cycle;
 
-		mutable std::set<Vec2> m_SortedData;
+		mutable std::vector<Vec2> m_SortedData;
 		mutable bool m_ResetCache = true;
 
 		int32_t m_Width;
@@ -1,4 +1,9 @@
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <limits>
 #include <memory>
 #include <print>
 #include <unordered_dense.h>
@@ -6,14 +11,45 @@
 #include <span>
 
 #include "LifeAlgorithm.h"
+#include "LifeKernel.h"
+#include "LifeRule.h"
+#include "ThreadPool.h"
 
 namespace gol 
 {
-	size_t LifeNodeHash::operator()(const gol::LifeNode* node) const
+	uint64_t HashChildren(const LifeNode& node)
 	{
-		if (!node) 
-			return std::hash<const void*>{}(nullptr);
-		return node->Hash;
+		auto hash = uint64_t { 0 };
+		hash = HashCombine(hash, node.NorthWest);
+		hash = HashCombine(hash, node.NorthEast);
+		hash = HashCombine(hash, node.SouthWest);
+		hash = HashCombine(hash, node.SouthEast);
+		hash = HashCombine(hash, node.Level);
+		return hash;
+	}
+
+	static bool SameChildren(const LifeNode& a, const LifeNode& b)
+	{
+		return a.NorthWest == b.NorthWest && a.NorthEast == b.NorthEast
+			&& a.SouthWest == b.SouthWest && a.SouthEast == b.SouthEast
+			&& a.Level == b.Level;
+	}
+
+	static constexpr uint64_t SaturatingAdd(uint64_t a, uint64_t b)
+	{
+		return b > std::numeric_limits<uint64_t>::max() - a ? std::numeric_limits<uint64_t>::max() : a + b;
+	}
+
+	enum Quadrant : int32_t { NorthWest, NorthEast, SouthWest, SouthEast };
+
+	// A 4x4 block of a leaf with the cell at (x, y) in bit y * 4 + x
+	static constexpr uint16_t LeafQuadrant(uint64_t bits, Quadrant quadrant)
+	{
+		const auto shift = (quadrant & 1) * 4 + (quadrant >> 1) * 32;
+		uint16_t result = 0;
+		for (int32_t y = 0; y < 4; y++)
+			result |= static_cast<uint16_t>(((bits >> (shift + y * LifeNode::LeafSize)) & 0xF) << (y * 4));
+		return result;
 	}
 
 	template class HashQuadtree::IteratorImpl<Vec2>;
@@ -25,32 +61,72 @@ namespace gol
 			m_Root = BuildTree(data);
 	}
 
-	int32_t HashQuadtree::CalculateTreeSize() const
+	HashQuadtree::HashQuadtree(const HashQuadtree& other)
+		: m_MemoryBudget(other.m_MemoryBudget)
+		, m_RootOffset(other.m_RootOffset)
+		, m_RootLevel(other.m_RootLevel)
+		, m_Rule(other.m_Rule)
 	{
-		if (m_Root == FalseNode || m_Root == TrueNode)
-			return 1;
-		
-		int32_t depth = 0;
-		const LifeNode* current = m_Root;
-		while (current != TrueNode && current != FalseNode) {
-			current = current->NorthWest;
-			depth++;
+		ankerl::unordered_dense::map<NodeIndex, NodeIndex> copied {};
+		m_Root = CopyNode(other, other.m_Root, copied);
+	}
+
+	HashQuadtree& HashQuadtree::operator=(const HashQuadtree& other)
+	{
+		if (this != &other)
+		{
+			auto copy = other;
+			*this = std::move(copy);
 		}
-		return 1 << depth;
+		return *this;
+	}
+
+	std::unique_ptr<LifeNodeArena> HashQuadtree::MakeNodeArena()
+	{
+		auto arena = std::make_unique<LifeNodeArena>();
+		arena->Emplace(LifeNode::Leaf(0));
+		return arena;
+	}
+
+	NodeIndex HashQuadtree::CopyNode(
+		const HashQuadtree& other,
+		NodeIndex node, 
+		ankerl::unordered_dense::map<NodeIndex, NodeIndex>& copied)
+	{
+		const auto& source = other.Node(node);
+		if (source.IsLeaf())
+			return FindOrCreateLeaf(source.Bits());
+
+		if (auto itr = copied.find(node); itr != copied.end())
+			return itr->second;
+
+		const auto result = FindOrCreate(
+			CopyNode(other, source.NorthWest, copied),
+			CopyNode(other, source.NorthEast, copied),
+			CopyNode(other, source.SouthWest, copied),
+			CopyNode(other, source.SouthEast, copied)
+		);
+		copied[node] = result;
+		return result;
+	}
+
+	int64_t HashQuadtree::CalculateTreeSize() const
+	{
+		return int64_t { 1 } << m_RootLevel;
 	}
 
 	bool HashQuadtree::empty() const
 	{
-		return m_Root == FalseNode;
+		return m_Root == EmptyLeaf;
 	}
 
 	HashQuadtree::Iterator HashQuadtree::begin()
 	{
-		if (m_Root == FalseNode)
+		if (m_Root == EmptyLeaf)
 			return end();
 		
-		int32_t size = CalculateTreeSize();
-		return Iterator { m_Root, m_RootOffset, size, false };
+		auto size = CalculateTreeSize();
+		return Iterator { m_NodeArena.get(), m_Root, m_RootOffset, size, false };
 	}
 
 	HashQuadtree::Iterator HashQuadtree::end()
@@ -60,11 +136,11 @@ namespace gol
 
 	HashQuadtree::ConstIterator HashQuadtree::begin() const 
 	{
-		if (m_Root == FalseNode)
+		if (m_Root == EmptyLeaf)
 			return end();
 		
-		int32_t size = CalculateTreeSize();
-		return ConstIterator(m_Root, m_RootOffset, size, false);
+		auto size = CalculateTreeSize();
+		return ConstIterator(m_NodeArena.get(), m_Root, m_RootOffset, size, false);
 	}
 
 	HashQuadtree::ConstIterator HashQuadtree::end() const
@@ -72,125 +148,684 @@ namespace gol
 		return ConstIterator();
 	}
 
-	const LifeNode* HashQuadtree::FindOrCreate(const LifeNode* nw, const LifeNode* ne, const LifeNode* sw, const LifeNode* se) 
+	HashQuadtree::CellRange HashQuadtree::CellsIn(const Rect& region) const
+	{
+		return { ConstIterator(m_NodeArena.get(), m_Root, m_RootOffset, CalculateTreeSize(), region), end() };
+	}
+
+	uint64_t HashQuadtree::Population() const
 	{
-		LifeNode toFind { nw, ne, sw, se };
-		if (auto itr = m_NodeMap.find(&toFind); itr != m_NodeMap.end()) 
-			return itr->first;
+		return Node(m_Root).Population;
+	}
 
-		auto node = std::make_unique<LifeNode>(nw, ne, sw, se);
-		m_NodeStorage.push_back(std::move(node));
-		m_NodeMap[m_NodeStorage.back().get()] = nullptr;
-		return m_NodeStorage.back().get();
+	uint64_t HashQuadtree::PopulationIn(const Rect& region) const
+	{
+		return PopulationIn(m_Root, m_RootOffset, m_RootLevel, region);
 	}
 
-	const LifeNode* HashQuadtree::CenteredSubnode(const LifeNode& node) 
+	uint64_t HashQuadtree::PopulationIn(NodeIndex node, Vec2L pos, int32_t level, const Rect& region) const
 	{
-		return FindOrCreate(
-			node.NorthWest->SouthEast,
-			node.NorthEast->SouthWest,
-			node.SouthWest->NorthEast,
-			node.SouthEast->NorthWest
-		);
+		const auto size = int64_t { 1 } << level;
+		const auto& quad = Node(node);
+		if (quad.IsEmpty() || !Overlaps(pos, size, region))
+			return 0;
+		if (region.InBounds(pos.X, pos.Y) && region.InBounds(pos.X + size - 1, pos.Y + size - 1))
+			return quad.Population;
+		if (quad.IsLeaf())
+			return std::popcount(quad.Bits() & LeafMask(pos, region));
+
+		const auto half = size / 2;
+		return SaturatingAdd(
+			SaturatingAdd(
+				PopulationIn(quad.NorthWest, pos, level - 1, region),
+				PopulationIn(quad.NorthEast, { pos.X + half, pos.Y }, level - 1, region)),
+			SaturatingAdd(
+				PopulationIn(quad.SouthWest, { pos.X, pos.Y + half }, level - 1, region),
+				PopulationIn(quad.SouthEast, { pos.X + half, pos.Y + half }, level - 1, region)));
 	}
 
-	const LifeNode* HashQuadtree::CenteredHorizontal(const LifeNode& west, const LifeNode& east) 
+	bool HashQuadtree::Overlaps(Vec2L pos, int64_t size, const Rect& region)
 	{
-		return FindOrCreate(
-			west.NorthEast->SouthEast,
-			east.NorthWest->SouthWest,
-			west.SouthEast->NorthEast,
-			east.SouthWest->NorthWest
-		);
+		return pos.X < int64_t { region.X } + region.Width && pos.Y < int64_t { region.Y } + region.Height
+			&& pos.X + size > region.X && pos.Y + size > region.Y;
 	}
 
-	const LifeNode* HashQuadtree::CenteredVertical(const LifeNode& north, const LifeNode& south) 
+	uint64_t HashQuadtree::LeafMask(Vec2L pos, const Rect& region)
 	{
-		return FindOrCreate(
-			north.SouthWest->SouthEast,
-			north.SouthEast->SouthWest,
-			south.NorthWest->NorthEast,
-			south.NorthEast->NorthWest
-		);
+		const auto clamp = [](int64_t value) { return std::clamp<int64_t>(value, 0, LifeNode::LeafSize); };
+		const auto left = clamp(region.X - pos.X);
+		const auto right = clamp(int64_t { region.X } + region.Width - pos.X);
+		const auto top = clamp(region.Y - pos.Y);
+		const auto bottom = clamp(int64_t { region.Y } + region.Height - pos.Y);
+		if (left >= right || top >= bottom)
+			return 0;
+
+		const auto rowMask = ((uint64_t { 1 } << (right - left)) - 1) << left;
+		uint64_t mask = 0;
+		for (auto y = top; y < bottom; y++)
+			mask |= rowMask << (y * LifeNode::LeafSize);
+		return mask;
 	}
 
-	const LifeNode* HashQuadtree::CenteredSubSubNode(const LifeNode& node) 
+	HashQuadtree& HashLife(HashQuadtree& data, const Rect& bounds, ThreadPool* pool)
 	{
-		return FindOrCreate(
-			node.NorthWest->SouthEast->SouthEast,
-			node.NorthEast->SouthWest->SouthWest,
-			node.SouthWest->NorthEast->NorthEast,
-			node.SouthEast->NorthWest->NorthWest
-		);
+		data.Advance(bounds, 0, pool);
+		return data;
+	}
+
+	NodeIndex HashQuadtree::FindOrCreate(NodeIndex nw, NodeIndex ne, NodeIndex sw, NodeIndex se) 
+	{
+		const auto& child = Node(nw);
+		const LifeNode toFind { nw, ne, sw, se, NoNode, child.Level + 1 };
+		return m_NodeTable.FindOrInsert(HashChildren(toFind),
+			[this, &toFind](NodeIndex node) { return SameChildren(Node(node), toFind); },
+			[this, &toFind, &child]
+			{
+				auto created = toFind;
+				created.Population = SaturatingAdd(
+					SaturatingAdd(child.Population, Node(toFind.NorthEast).Population),
+					SaturatingAdd(Node(toFind.SouthWest).Population, Node(toFind.SouthEast).Population));
+				return NewNode(created);
+			},
+			[this](NodeIndex unused) { DiscardNode(unused); });
+	}
+
+	NodeIndex HashQuadtree::FindOrCreateLeaf(uint64_t bits)
+	{
+		if (bits == 0)
+			return EmptyLeaf;
+
+		const auto toFind = LifeNode::Leaf(bits);
+		return m_NodeTable.FindOrInsert(HashChildren(toFind),
+			[this, &toFind](NodeIndex node) { return SameChildren(Node(node), toFind); },
+			[this, &toFind] { return NewNode(toFind); },
+			[this](NodeIndex unused) { DiscardNode(unused); });
+	}
+
+	NodeIndex HashQuadtree::NewNode(const LifeNode& node)
+	{
+		const auto index = m_Parallel ? m_NodeArena->EmplaceConcurrent(node) : m_NodeArena->Emplace(node);
+		return static_cast<NodeIndex>(index);
+	}
+
+	void HashQuadtree::DiscardNode(NodeIndex node)
+	{
+		// Only workers racing to intern the same node ever discard one
+		if (m_Parallel)
+			m_NodeArena->DestroyConcurrent(node);
+		else
+			m_NodeArena->Destroy(node);
+	}
+
+	NodeIndex HashQuadtree::LeafFromQuadrants(uint16_t nw, uint16_t ne, uint16_t sw, uint16_t se)
+	{
+		uint64_t bits = 0;
+		for (int32_t y = 0; y < 4; y++)
+		{
+			const auto row = y * LifeNode::LeafSize;
+			bits |= static_cast<uint64_t>((nw >> (y * 4)) & 0xF) << row;
+			bits |= static_cast<uint64_t>((ne >> (y * 4)) & 0xF) << (row + 4);
+			bits |= static_cast<uint64_t>((sw >> (y * 4)) & 0xF) << (row + 32);
+			bits |= static_cast<uint64_t>((se >> (y * 4)) & 0xF) << (row + 36);
+		}
+		return FindOrCreateLeaf(bits);
 	}
 
-	// TODO: Use more sophisticated algorithm for base case
-	const LifeNode* HashQuadtree::AdvanceBase(const LifeNode* node) 
+	// The Centered* helpers take the quarters of quarters of the nodes they are given. Once those
+	// quarters are leaves, the pieces are 4x4 blocks of the leaves' bitboards instead.
+
+	NodeIndex HashQuadtree::CenteredSubnode(const LifeNode& node) 
 	{
-		constexpr static auto gridSize = 4;
-		const std::array cells = 
+		const auto& nw = Node(node.NorthWest);
+		const auto& ne = Node(node.NorthEast);
+		const auto& sw = Node(node.SouthWest);
+		const auto& se = Node(node.SouthEast);
+		if (nw.IsLeaf())
+		{
+			return LeafFromQuadrants(
+				LeafQuadrant(nw.Bits(), SouthEast),
+				LeafQuadrant(ne.Bits(), SouthWest),
+				LeafQuadrant(sw.Bits(), NorthEast),
+				LeafQuadrant(se.Bits(), NorthWest)
+			);
+		}
+
+		return FindOrCreate(nw.SouthEast, ne.SouthWest, sw.NorthEast, se.NorthWest);
+	}
+
+	NodeIndex HashQuadtree::CenteredHorizontal(const LifeNode& west, const LifeNode& east) 
+	{
+		const auto& westNorth = Node(west.NorthEast);
+		const auto& eastNorth = Node(east.NorthWest);
+		const auto& westSouth = Node(west.SouthEast);
+		const auto& eastSouth = Node(east.SouthWest);
+		if (westNorth.IsLeaf())
+		{
+			return LeafFromQuadrants(
+				LeafQuadrant(westNorth.Bits(), SouthEast),
+				LeafQuadrant(eastNorth.Bits(), SouthWest),
+				LeafQuadrant(westSouth.Bits(), NorthEast),
+				LeafQuadrant(eastSouth.Bits(), NorthWest)
+			);
+		}
+
+		return FindOrCreate(westNorth.SouthEast, eastNorth.SouthWest, westSouth.NorthEast, eastSouth.NorthWest);
+	}
+
+	NodeIndex HashQuadtree::CenteredVertical(const LifeNode& north, const LifeNode& south) 
+	{
+		const auto& northWest = Node(north.SouthWest);
+		const auto& northEast = Node(north.SouthEast);
+		const auto& southWest = Node(south.NorthWest);
+		const auto& southEast = Node(south.NorthEast);
+		if (northWest.IsLeaf())
+		{
+			return LeafFromQuadrants(
+				LeafQuadrant(northWest.Bits(), SouthEast),
+				LeafQuadrant(northEast.Bits(), SouthWest),
+				LeafQuadrant(southWest.Bits(), NorthEast),
+				LeafQuadrant(southEast.Bits(), NorthWest)
+			);
+		}
+
+		return FindOrCreate(northWest.SouthEast, northEast.SouthWest, southWest.NorthEast, southEast.NorthWest);
+	}
+
+	NodeIndex HashQuadtree::CenteredSubSubNode(const LifeNode& node) 
+	{
+		return CenteredSubnode(LifeNode {
+			Node(node.NorthWest).SouthEast,
+			Node(node.NorthEast).SouthWest,
+			Node(node.SouthWest).NorthEast,
+			Node(node.SouthEast).NorthWest
+		});
+	}
+
+	// Steps the 16x16 block of a level 4 node with the bit-sliced row kernel. Every generation the
+	// block loses a row and column of valid cells on each side, so after up to four generations the
+	// center 8x8 is still exact.
+	NodeIndex HashQuadtree::AdvanceBase(const LifeNode& node) 
+	{
+		constexpr int32_t blockSize = 2 * LifeNode::LeafSize;
+		constexpr int32_t centerOffset = LifeNode::LeafSize / 2;
+
+		const std::array quarters = 
 		{ 
-			node->NorthWest->NorthWest, node->NorthWest->NorthEast, node->NorthEast->NorthWest, node->NorthEast->NorthEast,
-			node->NorthWest->SouthWest, node->NorthWest->SouthEast, node->NorthEast->SouthWest, node->NorthEast->SouthWest,
-			node->SouthWest->NorthWest, node->SouthWest->NorthEast, node->SouthEast->NorthWest, node->SouthEast->NorthEast,
-			node->SouthWest->SouthWest, node->SouthWest->SouthEast, node->SouthEast->SouthWest, node->SouthEast->SouthEast
+			Node(node.NorthWest).Bits(), Node(node.NorthEast).Bits(),
+			Node(node.SouthWest).Bits(), Node(node.SouthEast).Bits()
 		};
 
-		LifeHashSet result {};
-		for (auto x = 0; x < gridSize; x++) 
+		std::array<uint64_t, blockSize> rows {};
+		for (int32_t y = 0; y < LifeNode::LeafSize; y++)
+		{
+			const auto shift = y * LifeNode::LeafSize;
+			rows[y] = ((quarters[0] >> shift) & 0xFF) | (((quarters[1] >> shift) & 0xFF) << LifeNode::LeafSize);
+			rows[y + LifeNode::LeafSize] = ((quarters[2] >> shift) & 0xFF) | (((quarters[3] >> shift) & 0xFF) << LifeNode::LeafSize);
+		}
+
+		// rows[i] holds row i + generation of the block
+		const auto generations = 1 << std::min(m_StepLog2, 2);
+		std::array<uint64_t, blockSize> west {};
+		std::array<uint64_t, blockSize> east {};
+		std::array<uint64_t, blockSize> next {};
+		auto count = static_cast<size_t>(blockSize);
+		for (int32_t generation = 0; generation < generations; generation++)
 		{
-			for (auto y = 0; y < gridSize; y++)
+			for (size_t i = 0; i < count; i++)
 			{
-				auto index = y * gridSize + x;
-				if (cells[index] == TrueNode)
-					result.insert({x, y});
+				west[i] = rows[i] << 1;
+				east[i] = rows[i] >> 1;
 			}
+			count -= 2;
+			LifeKernel::StepRows(west.data(), rows.data(), east.data(), next.data(), count, m_Rule);
+			rows = next;
 		}
-		result = SparseLife(result, {0, 0, gridSize, gridSize});
 
-		const auto* quadtree = BuildTree(result);
-		return quadtree;
+		uint64_t bits = 0;
+		for (int32_t y = 0; y < LifeNode::LeafSize; y++)
+		{
+			const auto row = rows[y + centerOffset - generations];
+			bits |= ((row >> centerOffset) & 0xFF) << (y * LifeNode::LeafSize);
+		}
+		return FindOrCreateLeaf(bits);
 	}
 
-	const LifeNode* HashQuadtree::AdvanceNode(const LifeNode* node, int32_t level) {
-		return node;
+	template <size_t N, typename Compute>
+	std::array<NodeIndex, N> HashQuadtree::Fork(int32_t level, Compute&& compute)
+	{
+		std::array<NodeIndex, N> results {};
+		if (!m_Parallel || level < m_Parallel->CutoffLevel)
+		{
+			for (size_t i = 0; i < N; i++)
+				results[i] = compute(i);
+			return results;
+		}
+
+		ThreadPool::TaskGroup group;
+		for (size_t i = 1; i < N; i++)
+			m_Parallel->Pool.Submit(group, [&results, &compute, i] { results[i] = compute(i); });
+		results[0] = compute(0);
+		m_Parallel->Pool.Wait(group);
+		return results;
 	}
 
-	const LifeNode* HashQuadtree::AdvanceFast(const LifeNode* node, int32_t level) 
+	NodeIndex HashQuadtree::AdvanceNode(NodeIndex node, int32_t level) 
 	{
-		if (auto itr = m_NodeMap.find(node); itr != m_NodeMap.end()) 
-			return itr->second;
+		// Workers may race to advance the same node. Both arrive at the same interned result, and the
+		// release store makes the result's node visible to whoever reads the memo next.
+		std::atomic_ref<NodeIndex> memo { Node(node).Result };
+		if (const auto memoized = memo.load(std::memory_order_acquire); memoized != NoNode) 
+			return memoized;
 
-		if (level == 2) 
-			return AdvanceBase(node);
-		
-		const auto n00 = CenteredSubnode(*node->NorthWest);
-		const auto n01 = CenteredHorizontal(*node->NorthWest, *node->NorthEast);
-		const auto n02 = CenteredSubnode(*node->NorthEast);
-		const auto n10 = CenteredVertical(*node->NorthWest, *node->SouthWest);
-		const auto n11 = CenteredSubSubNode(*node);
-		const auto n12 = CenteredVertical(*node->NorthEast, *node->SouthEast);
-		const auto n20 = CenteredSubnode(*node->SouthWest);
-		const auto n21 = CenteredHorizontal(*node->SouthWest, *node->SouthEast);
-		const auto n22 = CenteredSubnode(*node->SouthEast);
+		const auto result = [this, node, level]()
+		{
+			const auto& quad = Node(node);
+			if (level == LifeNode::LeafLevel + 1) 
+				return AdvanceBase(quad);
+			if (m_StepLog2 >= level - 2)
+				return AdvanceFast(node, level);
+			
+			const auto& nw = Node(quad.NorthWest);
+			const auto& ne = Node(quad.NorthEast);
+			const auto& sw = Node(quad.SouthWest);
+			const auto& se = Node(quad.SouthEast);
+
+			const auto n00 = CenteredSubnode(nw);
+			const auto n01 = CenteredHorizontal(nw, ne);
+			const auto n02 = CenteredSubnode(ne);
+			const auto n10 = CenteredVertical(nw, sw);
+			const auto n11 = CenteredSubSubNode(quad);
+			const auto n12 = CenteredVertical(ne, se);
+			const auto n20 = CenteredSubnode(sw);
+			const auto n21 = CenteredHorizontal(sw, se);
+			const auto n22 = CenteredSubnode(se);
+
+			const std::array quarters =
+			{
+				FindOrCreate(n00, n01, n10, n11), FindOrCreate(n01, n02, n11, n12),
+				FindOrCreate(n10, n11, n20, n21), FindOrCreate(n11, n12, n21, n22)
+			};
+			const auto advanced = Fork<4>(level, [&](size_t i) { return AdvanceNode(quarters[i], level - 1); });
+			return FindOrCreate(advanced[0], advanced[1], advanced[2], advanced[3]);
+		}();
+
+		memo.store(result, std::memory_order_release);
+		return result;
+	}
+
+	// Advances the center of a level k node by 2^(k-2) generations by advancing twice through 
+	// nodes one level down, each of which moves 2^(k-3) generations
+	NodeIndex HashQuadtree::AdvanceFast(NodeIndex node, int32_t level) 
+	{
+		const auto& quad = Node(node);
+		const auto& nw = Node(quad.NorthWest);
+		const auto& ne = Node(quad.NorthEast);
+		const auto& sw = Node(quad.SouthWest);
+		const auto& se = Node(quad.SouthEast);
+
+		// The nine overlapping sub-squares, row by row
+		const std::array squares =
+		{
+			quad.NorthWest,
+			FindOrCreate(nw.NorthEast, ne.NorthWest, nw.SouthEast, ne.SouthWest),
+			quad.NorthEast,
+			FindOrCreate(nw.SouthWest, nw.SouthEast, sw.NorthWest, sw.NorthEast),
+			FindOrCreate(nw.SouthEast, ne.SouthWest, sw.NorthEast, se.NorthWest),
+			FindOrCreate(ne.SouthWest, ne.SouthEast, se.NorthWest, se.NorthEast),
+			quad.SouthWest,
+			FindOrCreate(sw.NorthEast, se.NorthWest, sw.SouthEast, se.SouthWest),
+			quad.SouthEast
+		};
+		const auto n = Fork<9>(level, [&](size_t i) { return AdvanceNode(squares[i], level - 1); });
+
+		const std::array quarters =
+		{
+			FindOrCreate(n[0], n[1], n[3], n[4]), FindOrCreate(n[1], n[2], n[4], n[5]),
+			FindOrCreate(n[3], n[4], n[6], n[7]), FindOrCreate(n[4], n[5], n[7], n[8])
+		};
+		const auto advanced = Fork<4>(level, [&](size_t i) { return AdvanceNode(quarters[i], level - 1); });
+		return FindOrCreate(advanced[0], advanced[1], advanced[2], advanced[3]);
+	}
+
+	void HashQuadtree::ResetMemoizedResults(int32_t stepLog2)
+	{
+		if (stepLog2 == m_StepLog2)
+			return;
+
+		ClearMemoizedResults();
+		m_StepLog2 = stepLog2;
+	}
+
+	void HashQuadtree::ClearMemoizedResults()
+	{
+		m_NodeTable.ForEach([this](NodeIndex node) { Node(node).Result = NoNode; });
+	}
+
+	void HashQuadtree::SetRule(const LifeRule& rule)
+	{
+		if (rule == m_Rule)
+			return;
+
+		m_Rule = rule;
+		ClearMemoizedResults();
+	}
+
+	bool HashQuadtree::HasEmptyBorder() const
+	{
+		// The border is made of the root's grandchildren, so they have to be nodes themselves
+		if (m_RootLevel < LifeNode::LeafLevel + 2)
+			return false;
+
+		const auto& root = Node(m_Root);
+		const auto& nw = Node(root.NorthWest);
+		const auto& ne = Node(root.NorthEast);
+		const auto& sw = Node(root.SouthWest);
+		const auto& se = Node(root.SouthEast);
+		return IsEmptyNode(nw.NorthWest) && IsEmptyNode(nw.NorthEast) && IsEmptyNode(nw.SouthWest)
+			&& IsEmptyNode(ne.NorthWest) && IsEmptyNode(ne.NorthEast) && IsEmptyNode(ne.SouthEast)
+			&& IsEmptyNode(sw.NorthWest) && IsEmptyNode(sw.SouthWest) && IsEmptyNode(sw.SouthEast)
+			&& IsEmptyNode(se.NorthEast) && IsEmptyNode(se.SouthWest) && IsEmptyNode(se.SouthEast);
+	}
+
+	void HashQuadtree::ExpandUniverse()
+	{
+		const auto halfSize = CalculateTreeSize() / 2;
+		if (m_RootLevel == LifeNode::LeafLevel)
+		{
+			// Each quarter of a leaf root moves to the inner corner of a leaf of its own
+			const auto bits = Node(m_Root).Bits();
+			m_Root = FindOrCreate(
+				LeafFromQuadrants(0, 0, 0, LeafQuadrant(bits, NorthWest)),
+				LeafFromQuadrants(0, 0, LeafQuadrant(bits, NorthEast), 0),
+				LeafFromQuadrants(0, LeafQuadrant(bits, SouthWest), 0, 0),
+				LeafFromQuadrants(LeafQuadrant(bits, SouthEast), 0, 0, 0)
+			);
+			m_RootOffset -= { halfSize, halfSize };
+			m_RootLevel++;
+			return;
+		}
+
+		const auto border = EmptyTree(halfSize);
+		const auto root = Node(m_Root);
+		m_Root = FindOrCreate(
+			FindOrCreate(border, border, border, root.NorthWest),
+			FindOrCreate(border, border, root.NorthEast, border),
+			FindOrCreate(border, root.SouthWest, border, border),
+			FindOrCreate(root.SouthEast, border, border, border)
+		);
+		m_RootOffset -= { halfSize, halfSize };
+		m_RootLevel++;
+	}
+
+	NodeIndex HashQuadtree::ClipToBounds(NodeIndex node, Vec2L pos, int32_t level, const Rect& bounds)
+	{
+		const auto size = int64_t { 1 } << level;
+		if (IsEmptyNode(node))
+			return node;
+		if (bounds.InBounds(pos.X, pos.Y) && bounds.InBounds(pos.X + size - 1, pos.Y + size - 1))
+			return node;
+		if (!Overlaps(pos, size, bounds))
+			return EmptyTree(size);
+
+		const auto quad = Node(node);
+		if (quad.IsLeaf())
+			return FindOrCreateLeaf(quad.Bits() & LeafMask(pos, bounds));
+
+		const auto half = size / 2;
+		return FindOrCreate(
+			ClipToBounds(quad.NorthWest, pos, level - 1, bounds),
+			ClipToBounds(quad.NorthEast, { pos.X + half, pos.Y }, level - 1, bounds),
+			ClipToBounds(quad.SouthWest, { pos.X, pos.Y + half }, level - 1, bounds),
+			ClipToBounds(quad.SouthEast, { pos.X + half, pos.Y + half }, level - 1, bounds)
+		);
+	}
+
+	bool HashQuadtree::InRoot(Vec2 pos) const
+	{
+		const auto size = CalculateTreeSize();
+		return pos.X >= m_RootOffset.X && pos.X < m_RootOffset.X + size
+			&& pos.Y >= m_RootOffset.Y && pos.Y < m_RootOffset.Y + size;
+	}
+
+	void HashQuadtree::Set(Vec2 pos, bool alive)
+	{
+		SetMany({ &pos, 1 }, alive);
+	}
+
+	void HashQuadtree::SetMany(std::span<const Vec2> cells, bool alive)
+	{
+		std::vector<Vec2> edits {};
+		edits.reserve(cells.size());
+		for (const auto cell : cells)
+		{
+			// Cells outside the root are already dead
+			if (alive || InRoot(cell))
+				edits.push_back(cell);
+		}
+		if (edits.empty())
+			return;
+
+		if (empty())
+			m_RootOffset = { edits.front().X, edits.front().Y };
+		while (!std::ranges::all_of(edits, [this](Vec2 cell) { return InRoot(cell); }))
+			ExpandUniverse();
+
+		m_Root = SetCells(m_Root, m_RootLevel, m_RootOffset, edits, alive);
+		if (IsEmptyNode(m_Root))
+		{
+			m_Root = EmptyLeaf;
+			m_RootOffset = { 0, 0 };
+			m_RootLevel = LifeNode::LeafLevel;
+		}
+	}
+
+	NodeIndex HashQuadtree::SetCells(NodeIndex node, int32_t level, Vec2L pos, std::span<Vec2> cells, bool alive)
+	{
+		if (cells.empty())
+			return node;
+
+		const auto quad = Node(node);
+		if (!alive && quad.IsEmpty())
+			return node;
+
+		if (level == LifeNode::LeafLevel)
+		{
+			auto bits = quad.Bits();
+			for (const auto cell : cells)
+			{
+				const auto bit = uint64_t { 1 } << ((cell.Y - pos.Y) * LifeNode::LeafSize + cell.X - pos.X);
+				bits = alive ? bits | bit : bits & ~bit;
+			}
+			return FindOrCreateLeaf(bits);
+		}
+
+		const auto half = int64_t { 1 } << (level - 1);
+		const auto midY = pos.Y + half;
+		const auto midX = pos.X + half;
+
+		auto itY = std::partition(cells.begin(), cells.end(), [midY](const Vec2& v) { return v.Y < midY; });
+		std::span<Vec2> north = {cells.begin(), itY};
+		std::span<Vec2> south = {itY, cells.end()};
+
+		auto itNorthX = std::partition(north.begin(), north.end(), [midX](const Vec2& v) { return v.X < midX; });
+		auto itSouthX = std::partition(south.begin(), south.end(), [midX](const Vec2& v) { return v.X < midX; });
 
 		return FindOrCreate(
-			AdvanceNode(FindOrCreate(n00, n01, n10, n11), level - 1),
-			AdvanceNode(FindOrCreate(n01, n02, n11, n12), level - 1),
-			AdvanceNode(FindOrCreate(n10, n11, n20, n21), level - 1),
-			AdvanceNode(FindOrCreate(n11, n12, n21, n22), level - 1)
+			SetCells(quad.NorthWest, level - 1, pos, {north.begin(), itNorthX}, alive),
+			SetCells(quad.NorthEast, level - 1, { pos.X + half, pos.Y }, {itNorthX, north.end()}, alive),
+			SetCells(quad.SouthWest, level - 1, { pos.X, pos.Y + half }, {south.begin(), itSouthX}, alive),
+			SetCells(quad.SouthEast, level - 1, { pos.X + half, pos.Y + half }, {itSouthX, south.end()}, alive)
 		);
 	}
 
+	void HashQuadtree::Advance(const Rect& bounds, int32_t stepLog2, ThreadPool* pool)
+	{
+		if (IsEmptyNode(m_Root))
+			return;
+
+		const bool bounded = bounds.Width > 0 && bounds.Height > 0;
+		if (bounded && stepLog2 > 0)
+		{
+			for (int64_t i = 0; i < (int64_t { 1 } << stepLog2); i++)
+				Advance(bounds, 0, pool);
+			return;
+		}
+		ResetMemoizedResults(stepLog2);
+
+		// The result of a level k node is its center after 2^stepLog2 generations, so the 
+		// pattern needs a margin wide enough that nothing escapes the center
+		while (m_RootLevel < m_StepLog2 + 2 || !HasEmptyBorder())
+			ExpandUniverse();
+		ExpandUniverse();
+
+		const auto quarterSize = CalculateTreeSize() / 4;
+		if (pool && pool->ThreadCount() > 1)
+		{
+			ParallelStep parallel { .Pool = *pool, .CutoffLevel = std::max(m_RootLevel - ParallelDepth, MinParallelLevel) };
+			m_Parallel = &parallel;
+			m_Root = AdvanceNode(m_Root, m_RootLevel);
+			m_Parallel = nullptr;
+		}
+		else
+			m_Root = AdvanceNode(m_Root, m_RootLevel);
+
+		// Nobody is probing the tables the node table outgrew during the step anymore
+		m_NodeTable.ReleaseRetiredTables();
+		m_RootOffset += { quarterSize, quarterSize };
+		m_RootLevel--;
+
+		if (bounded)
+			m_Root = ClipToBounds(m_Root, m_RootOffset, m_RootLevel, bounds);
+
+		while (HasEmptyBorder())
+		{
+			const auto shrinkOffset = CalculateTreeSize() / 4;
+			m_Root = CenteredSubnode(Node(m_Root));
+			m_RootOffset += { shrinkOffset, shrinkOffset };
+			m_RootLevel--;
+		}
+
+		if (IsEmptyNode(m_Root))
+		{
+			m_Root = EmptyLeaf;
+			m_RootOffset = { 0, 0 };
+			m_RootLevel = LifeNode::LeafLevel;
+		}
+
+		CollectIfOverBudget();
+	}
+
+	size_t HashQuadtree::MemoryUsage() const
+	{
+		return m_NodeArena->MemoryStats().BytesUsed + m_NodeTable.MemoryUsage();
+	}
+
+	HashQuadtree::PinHandle HashQuadtree::PinRoot()
+	{
+		const auto handle = m_NextPin++;
+		m_PinnedRoots[handle] = { m_Root, m_RootOffset, m_RootLevel };
+		return handle;
+	}
+
+	void HashQuadtree::UnpinRoot(PinHandle handle)
+	{
+		m_PinnedRoots.erase(handle);
+	}
+
+	void HashQuadtree::RestoreRoot(PinHandle handle)
+	{
+		auto itr = m_PinnedRoots.find(handle);
+		if (itr == m_PinnedRoots.end())
+			return;
+
+		m_Root = itr->second.Root;
+		m_RootOffset = itr->second.Offset;
+		m_RootLevel = itr->second.Level;
+	}
+
+	HashQuadtree::CollectionStats HashQuadtree::CollectGarbage()
+	{
+		const auto usageBefore = MemoryUsage();
+
+		std::vector<bool> marked(m_NodeArena->Extent());
+		std::vector<NodeIndex> pending {};
+
+		const auto mark = [&](NodeIndex node)
+		{
+			if (node != EmptyLeaf && !marked[node])
+			{
+				marked[node] = true;
+				pending.push_back(node);
+			}
+		};
+
+		mark(m_Root);
+		for (const auto& [handle, pinned] : m_PinnedRoots)
+			mark(pinned.Root);
+
+		while (!pending.empty())
+		{
+			const auto& node = Node(pending.back());
+			pending.pop_back();
+			if (node.IsLeaf())
+				continue;
+			mark(node.NorthWest);
+			mark(node.NorthEast);
+			mark(node.SouthWest);
+			mark(node.SouthEast);
+		}
+
+		// Memoized results are not roots, so surviving nodes forget results that were collected
+		const auto reclaimed = m_NodeTable.EraseIf([&](NodeIndex index)
+		{
+			if (!marked[index])
+			{
+				m_NodeArena->Destroy(index);
+				return true;
+			}
+			auto& node = Node(index);
+			if (node.Result != NoNode && !marked[node.Result])
+				node.Result = NoNode;
+			return false;
+		});
+
+		// Both caches are rebuilt on demand
+		m_EmptyNodeCache.clear();
+		m_TreeBuilderCache.clear();
+
+		m_LastCollection =
+		{
+			.NodesReclaimed = reclaimed,
+			.NodesRetained = m_NodeTable.size(),
+			.BytesReclaimed = usageBefore - MemoryUsage()
+		};
+		return m_LastCollection;
+	}
+
+	void HashQuadtree::CollectIfOverBudget()
+	{
+		if (m_MemoryBudget == 0)
+			return;
+
+		// When the live universe alone outgrows the budget, let the table double before
+		// collecting again instead of collecting after every step
+		const auto threshold = std::max(m_MemoryBudget, 2 * m_UsageAfterCollection);
+		if (MemoryUsage() > threshold)
+		{
+			CollectGarbage();
+			m_UsageAfterCollection = MemoryUsage();
+		}
+	}
+
 	size_t HashQuadtree::QuadHash::operator()(const QuadKey& key) const noexcept
 	{
 		return ankerl::unordered_dense::detail::wyhash::hash(&key, sizeof(key));
 	}
 
-	const LifeNode* HashQuadtree::EmptyTree(int32_t size)
+	NodeIndex HashQuadtree::EmptyTree(int64_t size)
 	{
-		if (size <= 1)
-			return FalseNode;
+		if (size <= LifeNode::LeafSize)
+			return EmptyLeaf;
 
         if (auto it = m_EmptyNodeCache.find(size); it != m_EmptyNodeCache.end()) 
             return it->second;
@@ -201,15 +836,20 @@ namespace gol
         return result;
 	}
 
-	const LifeNode* HashQuadtree::BuildTreeRegion(
+	NodeIndex HashQuadtree::BuildTreeRegion(
 		std::span<Vec2> cells,
 		Vec2 pos, int32_t size)
 	{
 		if (cells.empty())
 			return EmptyTree(size);
 
-		if (size == 1)
-			return TrueNode;
+		if (size == LifeNode::LeafSize)
+		{
+			uint64_t bits = 0;
+			for (const auto cell : cells)
+				bits |= uint64_t { 1 } << ((cell.Y - pos.Y) * LifeNode::LeafSize + cell.X - pos.X);
+			return FindOrCreateLeaf(bits);
+		}
 		
 		const auto half = size / 2;
 		const auto midY = pos.Y + half;
@@ -230,12 +870,12 @@ namespace gol
 		);
 	}
 
-	const LifeNode* HashQuadtree::BuildTree(const LifeHashSet& cells) 
+	NodeIndex HashQuadtree::BuildTree(const LifeHashSet& cells) 
 	{
 		if (cells.empty())
 		{
 			m_RootOffset = {0, 0};
-			return FalseNode;
+			return EmptyLeaf;
 		}
 
 		const auto& [minX, maxX] = std::ranges::minmax_element(cells, 
@@ -244,12 +884,13 @@ namespace gol
 			[](const Vec2& a, const Vec2& b) { return a.Y < b.Y; });
 		
 		const auto neighborhoodSize = std::max(maxX->X - minX->X, maxY->Y - minY->Y) + 1;
-		const auto gridExponent = std::ceil(std::log2(neighborhoodSize));
+		const auto gridExponent = std::max(std::ceil(std::log2(neighborhoodSize)), double { LifeNode::LeafLevel });
 		const auto gridSize = static_cast<int32_t>(std::pow(2, gridExponent));
 		
         m_RootOffset = {minX->X, minY->Y};
+		m_RootLevel = static_cast<int32_t>(gridExponent);
 		
 		std::vector<Vec2> cellVec(cells.begin(), cells.end());
-		return BuildTreeRegion(cellVec, m_RootOffset, gridSize);
+		return BuildTreeRegion(cellVec, {minX->X, minY->Y}, gridSize);
 	}
 }
\ No newline at end of file
@@ -1,15 +1,25 @@
 #ifndef __HashQuadtree_h__
 #define __HashQuadtree_h__
 
+#include <array>
+#include <bit>
 #include <iterator>
+#include <memory>
 #include <ranges>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
+#include <span>
 #include <stack>
 #include <unordered_dense.h>
+#include <vector>
 
+#include "ConcurrentInternTable.h"
 #include "Graphics2D.h"
 #include "LifeHashSet.h"
+#include "LifeRule.h"
+#include "SlabArena.h"
+#include "ThreadPool.h"
 
 namespace gol 
 {
@@ -18,50 +28,59 @@ namespace gol
         return seed ^ (v + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
     }
 
+    // Nodes refer to each other by their index in the tree's node arena
+    using NodeIndex = uint32_t;
+
+    // The empty leaf sits at the same index in every tree
+    inline constexpr NodeIndex EmptyLeaf = 0;
+
+    // Marks a memoized result that has not been computed yet
+    inline constexpr NodeIndex NoNode = std::numeric_limits<NodeIndex>::max();
+
+    // Trees bottom out in 8x8 leaves. A leaf keeps its cells in the child fields as a bitboard with
+    // the cell at (x, y) in bit y * 8 + x, so nodes below the leaf level are never interned.
     struct LifeNode 
     {
-        const LifeNode* NorthWest;
-        const LifeNode* NorthEast;
-        const LifeNode* SouthWest;
-        const LifeNode* SouthEast;
-    
-        uint64_t Hash;
-        bool IsEmpty;
-    
-        constexpr LifeNode(
-            const LifeNode* nw, 
-            const LifeNode* ne, 
-            const LifeNode* sw, 
-            const LifeNode* se,
-			bool isLeaf = false
-        )
-            : NorthWest(nw), NorthEast(ne), SouthWest(sw), SouthEast(se), Hash(0ULL), IsEmpty(false)
-        {
-            if (!isLeaf)
-            {
-                auto check = [](const LifeNode* n) { return n == nullptr || n->IsEmpty; };
-                IsEmpty = check(nw) && check(ne) && check(sw) && check(se);
-            }
+        static constexpr int32_t LeafLevel = 3;
+        static constexpr int32_t LeafSize = 1 << LeafLevel;
+
+        NodeIndex NorthWest = EmptyLeaf;
+        NodeIndex NorthEast = EmptyLeaf;
+        NodeIndex SouthWest = EmptyLeaf;
+        NodeIndex SouthEast = EmptyLeaf;
+
+        // Center of the node after 2^stepLog2 generations, for the tree's current step size
+        NodeIndex Result = NoNode;
+
+        // Also tells leaves apart from inner nodes whose child indices happen to match a leaf's bits
+        uint32_t Level = LeafLevel;
+
+        // Saturates instead of wrapping for universes with more than 2^64 cells
+        uint64_t Population = 0;
 
-            if consteval {} else 
+        bool IsEmpty() const { return Population == 0; }
+        bool IsLeaf() const { return Level == LeafLevel; }
+
+        uint64_t Bits() const { return NorthWest | (uint64_t { NorthEast } << 32); }
+
+        static LifeNode Leaf(uint64_t bits)
+        {
+            return
             {
-                Hash = HashCombine(Hash, reinterpret_cast<uint64_t>(NorthWest));
-                Hash = HashCombine(Hash, reinterpret_cast<uint64_t>(NorthEast));
-                Hash = HashCombine(Hash, reinterpret_cast<uint64_t>(SouthWest));
-                Hash = HashCombine(Hash, reinterpret_cast<uint64_t>(SouthEast));
-            }
+                .NorthWest = static_cast<NodeIndex>(bits),
+                .NorthEast = static_cast<NodeIndex>(bits >> 32),
+                .Population = static_cast<uint64_t>(std::popcount(bits))
+            };
         }
     };
 
-    struct LifeNodeHash 
-    {
-    	size_t operator()(const gol::LifeNode* node) const;
-    };
+    static_assert(sizeof(LifeNode) <= 32, "Two nodes should share a cache line");
+
+    using LifeNodeArena = SlabArena<LifeNode>;
 
-    constexpr inline LifeNode StaticTrueNode { nullptr, nullptr, nullptr, nullptr, true };
+    // Hashes only depend on child indices, so the same sequence of edits always builds the same table
+    uint64_t HashChildren(const LifeNode& node);
 
-    constexpr const LifeNode* TrueNode = &StaticTrueNode;
-    constexpr const LifeNode* FalseNode = nullptr;
 }
 
 namespace gol 
@@ -73,9 +92,9 @@ namespace gol
         class IteratorImpl {    
         private:
             struct StackFrame {
-                const LifeNode* node;
-                Vec2 position;
-                int32_t size;
+                NodeIndex node;
+                Vec2L position;
+                int64_t size;
                 uint8_t quadrant;
             };
         public:
@@ -98,16 +117,45 @@ namespace gol
             reference operator*() const;
             pointer operator->() const;
         private:
-            IteratorImpl(const LifeNode* root, Vec2 offset, int32_t size, bool isEnd);
+            IteratorImpl(const LifeNodeArena* nodes, NodeIndex root, Vec2L offset, int64_t size, bool isEnd);
+            IteratorImpl(const LifeNodeArena* nodes, NodeIndex root, Vec2L offset, int64_t size, const Rect& region);
             void AdvanceToNext();
         private:
+            const LifeNodeArena* m_Nodes = nullptr;
             std::stack<StackFrame> m_Stack;
+
+            // Cells of the leaf being walked that have not been returned yet
+            uint64_t m_LeafBits = 0;
+            Vec2L m_LeafPos {};
+
+            // Quadrants outside the region are skipped entirely when culling
+            Rect m_Region {};
+            bool m_Culled = false;
+
             value_type m_Current;
             bool m_IsEnd;
         };
+    public:
+        struct CollectionStats
+        {
+            size_t NodesReclaimed = 0;
+            size_t NodesRetained = 0;
+            size_t BytesReclaimed = 0;
+        };
+
+        using PinHandle = uint32_t;
+
+        // Collections run automatically once the node table grows past this many bytes
+        static constexpr size_t DefaultMemoryBudget = size_t { 1 } << 30;
     public:
         HashQuadtree() = default;
         HashQuadtree(const LifeHashSet& data);
+
+        HashQuadtree(const HashQuadtree& other);
+        HashQuadtree& operator=(const HashQuadtree& other);
+
+        HashQuadtree(HashQuadtree&& other) noexcept = default;
+        HashQuadtree& operator=(HashQuadtree&& other) noexcept = default;
     public:
         using Iterator = IteratorImpl<Vec2>;
         using ConstIterator = IteratorImpl<const Vec2>;
@@ -120,38 +168,130 @@ namespace gol
         ConstIterator begin() const;
         ConstIterator end() const;
 
-        void Advance(const Rect& bounds);
+        // Live cells inside the region, skipping every quadrant that lies outside it
+        using CellRange = std::ranges::subrange<ConstIterator>;
+        CellRange CellsIn(const Rect& region) const;
+
+        // Read from the population stored in each node, so only nodes straddling the edge of the
+        // region are visited
+        uint64_t Population() const;
+        uint64_t PopulationIn(const Rect& region) const;
+
+        // Advances the universe by 2^stepLog2 generations. Bounded universes are still stepped one
+        // generation at a time, since cells leaving the bounds must be cleared every generation.
+        // With a pool, the largest sub-squares near the root are advanced in parallel.
+        void Advance(const Rect& bounds, int32_t stepLog2 = 0, ThreadPool* pool = nullptr);
+
+        // Changing the rule forgets every memoized result
+        const LifeRule& Rule() const { return m_Rule; }
+        void SetRule(const LifeRule& rule);
+
+        // Edits rebuild only the nodes on the paths from the edited leaves up to the root and reuse
+        // every other subtree, growing the root first when a cell falls outside it
+        void Set(Vec2 pos, bool alive);
+        void SetMany(std::span<const Vec2> cells, bool alive);
+
+        // Within one tree, the same root at the same place is the same universe
+        NodeIndex Root() const { return m_Root; }
+        Vec2L RootOffset() const { return m_RootOffset; }
+        int32_t RootLevel() const { return m_RootLevel; }
+
+        LifeNodeArena::Stats NodeMemoryStats() const { return m_NodeArena->MemoryStats(); }
+
+        // Bytes held by interned nodes and the table that interns them
+        size_t MemoryUsage() const;
+
+        // A budget of 0 disables automatic collection
+        size_t MemoryBudget() const { return m_MemoryBudget; }
+        void SetMemoryBudget(size_t bytes) { m_MemoryBudget = bytes; }
+
+        // Keeps the current universe alive through collections, e.g. for undo snapshots.
+        // Pins belong to this tree and are not carried over by copies.
+        PinHandle PinRoot();
+        void UnpinRoot(PinHandle handle);
+        void RestoreRoot(PinHandle handle);
+
+        // Frees every node that is unreachable from the current and pinned roots
+        CollectionStats CollectGarbage();
+        const CollectionStats& LastCollection() const { return m_LastCollection; }
     private:
-        const LifeNode* AdvanceNode(const LifeNode* node, int32_t level);
+        NodeIndex AdvanceNode(NodeIndex node, int32_t level);
 
-        const LifeNode* FindOrCreate(
-            const LifeNode* nw, 
-            const LifeNode* ne, 
-            const LifeNode* sw,
-            const LifeNode* se
+        NodeIndex AdvanceFast(NodeIndex node, int32_t level);
+
+        // Computes compute(0) to compute(N - 1), as tasks on the pool when the level is high enough
+        template <size_t N, typename Compute>
+        std::array<NodeIndex, N> Fork(int32_t level, Compute&& compute);
+
+        // Workers of a parallel step share the arena, so they allocate through its concurrent side
+        NodeIndex NewNode(const LifeNode& node);
+        void DiscardNode(NodeIndex node);
+
+        void ResetMemoizedResults(int32_t stepLog2);
+        void ClearMemoizedResults();
+
+        NodeIndex CopyNode(
+            const HashQuadtree& other,
+            NodeIndex node, 
+            ankerl::unordered_dense::map<NodeIndex, NodeIndex>& copied);
+
+        NodeIndex FindOrCreate(
+            NodeIndex nw, 
+            NodeIndex ne, 
+            NodeIndex sw,
+            NodeIndex se
         );
 
-        const LifeNode* BuildTreeRegion(
+        NodeIndex FindOrCreateLeaf(uint64_t bits);
+
+        // Builds a leaf from four 4x4 blocks laid out like LeafQuadrant returns them
+        NodeIndex LeafFromQuadrants(uint16_t nw, uint16_t ne, uint16_t sw, uint16_t se);
+
+        const LifeNode& Node(NodeIndex index) const { return (*m_NodeArena)[index]; }
+        LifeNode& Node(NodeIndex index) { return (*m_NodeArena)[index]; }
+
+        bool IsEmptyNode(NodeIndex index) const { return Node(index).IsEmpty(); }
+
+        NodeIndex BuildTreeRegion(
             std::span<Vec2> cells, 
             Vec2 pos, int32_t size);
 
-        const LifeNode* EmptyTree(int32_t size);
+        NodeIndex EmptyTree(int64_t size);
+
+	    NodeIndex BuildTree(const LifeHashSet& data);
+
+		NodeIndex CenteredSubnode(const LifeNode& node);
+
+		NodeIndex CenteredHorizontal(const LifeNode& west, const LifeNode& east);
+
+		NodeIndex CenteredVertical(const LifeNode& north, const LifeNode& south);
+
+		NodeIndex CenteredSubSubNode(const LifeNode& node);
+
+		NodeIndex AdvanceBase(const LifeNode& node);
+
+		NodeIndex ClipToBounds(NodeIndex node, Vec2L pos, int32_t level, const Rect& bounds);
+
+		NodeIndex SetCells(NodeIndex node, int32_t level, Vec2L pos, std::span<Vec2> cells, bool alive);
+
+		bool InRoot(Vec2 pos) const;
 
-	    const LifeNode* BuildTree(const LifeHashSet& data);
+		uint64_t PopulationIn(NodeIndex node, Vec2L pos, int32_t level, const Rect& region) const;
 
-		const LifeNode* CenteredSubnode(const LifeNode& node);
+		static bool Overlaps(Vec2L pos, int64_t size, const Rect& region);
 
-		const LifeNode* CenteredHorizontal(const LifeNode& west, const LifeNode& east);
+		// Bits of the leaf at pos that fall inside the region
+		static uint64_t LeafMask(Vec2L pos, const Rect& region);
 
-		const LifeNode* CenteredVertical(const LifeNode& north, const LifeNode& south);
+		void ExpandUniverse();
 
-		const LifeNode* CenteredSubSubNode(const LifeNode& node);
+		bool HasEmptyBorder() const;
 
-		const LifeNode* AdvanceBase(const LifeNode* node);
+		void CollectIfOverBudget();
 
-		const LifeNode* AdvanceFast(const LifeNode* node, int32_t level);
+		int64_t CalculateTreeSize() const;
 
-		int32_t CalculateTreeSize() const;
+		static std::unique_ptr<LifeNodeArena> MakeNodeArena();
     private:
 		struct QuadKey
 		{
@@ -168,16 +308,49 @@ namespace gol
 			size_t operator()(const QuadKey& key) const noexcept;
 		};
 
-        ankerl::unordered_dense::map<QuadKey, const LifeNode*, QuadHash> m_TreeBuilderCache {};
-        ankerl::unordered_dense::map<int32_t, const LifeNode*> m_EmptyNodeCache {};
+        ankerl::unordered_dense::map<QuadKey, NodeIndex, QuadHash> m_TreeBuilderCache {};
+        ankerl::unordered_dense::map<int64_t, NodeIndex> m_EmptyNodeCache {};
 	private:
+        // Held by pointer so nodes stay put when the tree is moved
+        std::unique_ptr<LifeNodeArena> m_NodeArena = MakeNodeArena();
 
-        ankerl::unordered_dense::map<const LifeNode*, const LifeNode*, LifeNodeHash> m_NodeMap {};
+        // Every interned node except the empty leaf. Workers of a parallel step intern through it
+        // without any locking.
+        ConcurrentInternTable m_NodeTable {};
 
-        std::vector<std::unique_ptr<LifeNode>> m_NodeStorage {};
+        struct PinnedRoot
+        {
+            NodeIndex Root;
+            Vec2L Offset;
+            int32_t Level;
+        };
+
+        // Forking stops this many levels below the root, and never reaches below MinParallelLevel,
+        // where sub-squares are too small or too likely to be memoized to be worth a task
+        static constexpr int32_t ParallelDepth = 3;
+        static constexpr int32_t MinParallelLevel = LifeNode::LeafLevel + 6;
+
+        struct ParallelStep
+        {
+            ThreadPool& Pool;
+            int32_t CutoffLevel;
+        };
+
+        // Only set for the duration of a parallel step
+        ParallelStep* m_Parallel = nullptr;
+
+        ankerl::unordered_dense::map<PinHandle, PinnedRoot> m_PinnedRoots {};
+        PinHandle m_NextPin = 0;
+
+        size_t m_MemoryBudget = DefaultMemoryBudget;
+        size_t m_UsageAfterCollection = 0;
+        CollectionStats m_LastCollection {};
         
-        const LifeNode* m_Root = FalseNode;        
-        Vec2 m_RootOffset;    
+        NodeIndex m_Root = EmptyLeaf;        
+        Vec2L m_RootOffset;    
+        int32_t m_RootLevel = LifeNode::LeafLevel;
+        int32_t m_StepLog2 = 0;
+        LifeRule m_Rule {};
     };
 
     extern template class HashQuadtree::IteratorImpl<Vec2>;
@@ -185,28 +358,47 @@ namespace gol
 
     template <typename T>
 	HashQuadtree::IteratorImpl<T>::IteratorImpl(
-		const LifeNode* root, Vec2 offset, int32_t size, bool isEnd)
-		: m_Current(offset), m_IsEnd(isEnd)
+		const LifeNodeArena* nodes, NodeIndex root, Vec2L offset, int64_t size, bool isEnd)
+		: m_Nodes(nodes), m_Current(), m_IsEnd(isEnd)
 	{
-		if (!isEnd && root != FalseNode) {
+		if (!isEnd && root != EmptyLeaf) {
 			m_Stack.push({root, offset, size, 0});
 			AdvanceToNext();
 		}
 	}
 
+    template <typename T>
+	HashQuadtree::IteratorImpl<T>::IteratorImpl(
+		const LifeNodeArena* nodes, NodeIndex root, Vec2L offset, int64_t size, const Rect& region)
+		: m_Nodes(nodes), m_Region(region), m_Culled(true), m_Current(), m_IsEnd(false)
+	{
+		if (root != EmptyLeaf && Overlaps(offset, size, region))
+			m_Stack.push({root, offset, size, 0});
+		AdvanceToNext();
+	}
+
 	template <typename T>
 	void HashQuadtree::IteratorImpl<T>::AdvanceToNext()
 	{
-		while (!m_Stack.empty()) {
+		while (m_LeafBits != 0 || !m_Stack.empty()) {
+			// Drain the current leaf before descending any further
+			if (m_LeafBits != 0) {
+				const auto bit = std::countr_zero(m_LeafBits);
+				m_LeafBits &= m_LeafBits - 1;
+				m_Current = {
+					static_cast<int32_t>(m_LeafPos.X + bit % LifeNode::LeafSize),
+					static_cast<int32_t>(m_LeafPos.Y + bit / LifeNode::LeafSize)
+				};
+				return;  // Found a live cell
+			}
+
 			auto& frame = m_Stack.top();
 			
-			// If we're at a leaf (size == 1)
-			if (frame.size == 1) {
-				if (frame.node == TrueNode) {
-					m_Current = frame.position;
-					m_Stack.pop();
-					return;  // Found a live cell
-				}
+			if (frame.size == LifeNode::LeafSize) {
+				m_LeafBits = (*m_Nodes)[frame.node].Bits();
+				if (m_Culled)
+					m_LeafBits &= LeafMask(frame.position, m_Region);
+				m_LeafPos = frame.position;
 				m_Stack.pop();
 				continue;
 			}
@@ -218,30 +410,31 @@ namespace gol
 			}
 			
 			const auto halfSize = frame.size / 2;
-			const LifeNode* child = nullptr;
+			const auto& node = (*m_Nodes)[frame.node];
+			auto child = EmptyLeaf;
 			auto childPos = frame.position;
 			
 			switch (frame.quadrant++) {
 				case 0: 
-					child = frame.node->NorthWest; 
+					child = node.NorthWest; 
 					break;
 				case 1: 
-					child = frame.node->NorthEast;
+					child = node.NorthEast;
 					childPos.X += halfSize;
 					break;
 				case 2: 
-					child = frame.node->SouthWest;
+					child = node.SouthWest;
 					childPos.Y += halfSize;
 					break;
 				case 3: 
-					child = frame.node->SouthEast;
+					child = node.SouthEast;
 					childPos.X += halfSize;
 					childPos.Y += halfSize;
 					break;
 			}
             m_Stack.top().quadrant = frame.quadrant;
 			
-			if (child != FalseNode && !child->IsEmpty) {
+			if (!(*m_Nodes)[child].IsEmpty() && (!m_Culled || Overlaps(childPos, halfSize, m_Region))) {
 				m_Stack.push({child, childPos, halfSize, 0});
 			}
 		}
@@ -4,21 +4,33 @@
 #include <functional>
 #include <span>
 #include <variant>
+#include <vector>
 
 #include "Graphics2D.h"
 #include "HashQuadtree.h"
 #include "LifeHashSet.h"
+#include "LifeRule.h"
+#include "LifeTileMap.h"
+#include "ThreadPool.h"
 
 namespace gol
 {
 	
-	LifeHashSet SparseLife(std::span<const Vec2> data, const Rect& bounds);
+	LifeHashSet SparseLife(std::span<const Vec2> data, const Rect& bounds, const LifeRule& rule = LifeRules::Conway);
 
-	const HashQuadtree& HashLife(const HashQuadtree& data, const Rect& bounds);
+	// Sorts neighbor contributions instead of hashing them. The result is sorted by X, then Y.
+	std::vector<Vec2> SweepLife(std::span<const Vec2> data, const Rect& bounds, const LifeRule& rule = LifeRules::Conway);
+
+	// The largest sub-squares are advanced in parallel when a pool is given
+	HashQuadtree& HashLife(HashQuadtree& data, const Rect& bounds, ThreadPool* pool = nullptr);
+
+	LifeTileMap& TileLife(LifeTileMap& data, const Rect& bounds, ThreadPool* pool = nullptr);
 
 	enum class LifeAlgorithm {
 		SparseLife,
-		HashLife
+		HashLife,
+		TileLife,
+		SweepLife
 	};
 }
 
@@ -0,0 +1,411 @@
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+#include "LifeKernel.h"
+#include "LifeRule.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define GOL_KERNEL_X86
+	#include <immintrin.h>
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#include <intrin.h>
+	#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+	#define GOL_TARGET(isa) __attribute__((target(isa)))
+#else
+	#define GOL_TARGET(isa)
+#endif
+
+namespace gol
+{
+	// Bit-sliced neighbor count: every bit position is an independent cell, so the rows above and
+	// below are reduced with full adders, the side neighbors with a half adder, and the partial sums
+	// are combined into the ones, twos and fours-or-more bits of the count
+	static uint64_t NextRowScalar(
+		uint64_t westAbove, uint64_t above, uint64_t eastAbove,
+		uint64_t west, uint64_t center, uint64_t east,
+		uint64_t westBelow, uint64_t below, uint64_t eastBelow)
+	{
+		const auto aboveOnes = westAbove ^ above ^ eastAbove;
+		const auto aboveTwos = (westAbove & above) | (eastAbove & (westAbove ^ above));
+
+		const auto belowOnes = westBelow ^ below ^ eastBelow;
+		const auto belowTwos = (westBelow & below) | (eastBelow & (westBelow ^ below));
+
+		const auto sideOnes = west ^ east;
+		const auto sideTwos = west & east;
+
+		const auto ones = aboveOnes ^ belowOnes ^ sideOnes;
+		const auto onesCarry = (aboveOnes & belowOnes) | (sideOnes & (aboveOnes ^ belowOnes));
+
+		const auto twosPartial = aboveTwos ^ belowTwos ^ sideTwos;
+		const auto twosCarry = (aboveTwos & belowTwos) | (sideTwos & (aboveTwos ^ belowTwos));
+
+		const auto twos = twosPartial ^ onesCarry;
+		const auto foursOrMore = twosCarry | (twosPartial & onesCarry);
+
+		return twos & ~foursOrMore & (ones | center);
+	}
+
+	static void StepRowsScalar(
+		const uint64_t* west, const uint64_t* middle, const uint64_t* east,
+		uint64_t* result, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			result[i] = NextRowScalar(
+				west[i],     middle[i],     east[i],
+				west[i + 1], middle[i + 1], east[i + 1],
+				west[i + 2], middle[i + 2], east[i + 2]
+			);
+		}
+	}
+
+	// Same adders as NextRowScalar, carried through to the eights bit so that every neighbor count
+	// from 0 to 8 can be told apart. Rules fixed at compile time fold down to the counts they use.
+	template <typename Rule>
+	static uint64_t NextRowForRule(
+		uint64_t westAbove, uint64_t above, uint64_t eastAbove,
+		uint64_t west, uint64_t center, uint64_t east,
+		uint64_t westBelow, uint64_t below, uint64_t eastBelow,
+		const Rule& rule)
+	{
+		const auto aboveOnes = westAbove ^ above ^ eastAbove;
+		const auto aboveTwos = (westAbove & above) | (eastAbove & (westAbove ^ above));
+
+		const auto belowOnes = westBelow ^ below ^ eastBelow;
+		const auto belowTwos = (westBelow & below) | (eastBelow & (westBelow ^ below));
+
+		const auto sideOnes = west ^ east;
+		const auto sideTwos = west & east;
+
+		const auto ones = aboveOnes ^ belowOnes ^ sideOnes;
+		const auto onesCarry = (aboveOnes & belowOnes) | (sideOnes & (aboveOnes ^ belowOnes));
+
+		const auto twosPartial = aboveTwos ^ belowTwos ^ sideTwos;
+		const auto twosCarry = (aboveTwos & belowTwos) | (sideTwos & (aboveTwos ^ belowTwos));
+
+		const auto twos = twosPartial ^ onesCarry;
+		const auto foursCarry = twosPartial & onesCarry;
+		const auto fours = twosCarry ^ foursCarry;
+		const auto eights = twosCarry & foursCarry;
+
+		const std::array bits = { ones, twos, fours, eights };
+		const auto countIs = [&bits](int32_t count)
+		{
+			auto match = ~uint64_t { 0 };
+			for (int32_t bit = 0; bit < 4; bit++)
+				match &= (count >> bit) & 1 ? bits[bit] : ~bits[bit];
+			return match;
+		};
+
+		uint64_t next = 0;
+		[&]<int32_t... Counts>(std::integer_sequence<int32_t, Counts...>)
+		{
+			([&]
+			{
+				const bool born = rule.Born(Counts);
+				const bool survives = rule.Survives(Counts);
+				if (born || survives)
+					next |= countIs(Counts) & (born && survives ? ~uint64_t { 0 } : born ? ~center : center);
+			}(), ...);
+		}(std::make_integer_sequence<int32_t, 9> {});
+		return next;
+	}
+
+	template <typename Rule>
+	static void StepRowsForRule(
+		const uint64_t* west, const uint64_t* middle, const uint64_t* east,
+		uint64_t* result, size_t count, const Rule& rule)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			result[i] = NextRowForRule(
+				west[i],     middle[i],     east[i],
+				west[i + 1], middle[i + 1], east[i + 1],
+				west[i + 2], middle[i + 2], east[i + 2],
+				rule
+			);
+		}
+	}
+
+#ifdef GOL_KERNEL_X86
+	GOL_TARGET("sse2")
+	static void StepRowsSSE2(
+		const uint64_t* west, const uint64_t* middle, const uint64_t* east,
+		uint64_t* result, size_t count)
+	{
+		size_t i = 0;
+		for (; i + 2 <= count; i += 2)
+		{
+			const auto westAbove = _mm_loadu_si128(reinterpret_cast<const __m128i*>(west + i));
+			const auto above     = _mm_loadu_si128(reinterpret_cast<const __m128i*>(middle + i));
+			const auto eastAbove = _mm_loadu_si128(reinterpret_cast<const __m128i*>(east + i));
+			const auto westSide  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(west + i + 1));
+			const auto center    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(middle + i + 1));
+			const auto eastSide  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(east + i + 1));
+			const auto westBelow = _mm_loadu_si128(reinterpret_cast<const __m128i*>(west + i + 2));
+			const auto below     = _mm_loadu_si128(reinterpret_cast<const __m128i*>(middle + i + 2));
+			const auto eastBelow = _mm_loadu_si128(reinterpret_cast<const __m128i*>(east + i + 2));
+
+			const auto aboveXor  = _mm_xor_si128(westAbove, above);
+			const auto aboveOnes = _mm_xor_si128(aboveXor, eastAbove);
+			const auto aboveTwos = _mm_or_si128(_mm_and_si128(westAbove, above), _mm_and_si128(eastAbove, aboveXor));
+
+			const auto belowXor  = _mm_xor_si128(westBelow, below);
+			const auto belowOnes = _mm_xor_si128(belowXor, eastBelow);
+			const auto belowTwos = _mm_or_si128(_mm_and_si128(westBelow, below), _mm_and_si128(eastBelow, belowXor));
+
+			const auto sideOnes = _mm_xor_si128(westSide, eastSide);
+			const auto sideTwos = _mm_and_si128(westSide, eastSide);
+
+			const auto onesXor   = _mm_xor_si128(aboveOnes, belowOnes);
+			const auto ones      = _mm_xor_si128(onesXor, sideOnes);
+			const auto onesCarry = _mm_or_si128(_mm_and_si128(aboveOnes, belowOnes), _mm_and_si128(sideOnes, onesXor));
+
+			const auto twosXor     = _mm_xor_si128(aboveTwos, belowTwos);
+			const auto twosPartial = _mm_xor_si128(twosXor, sideTwos);
+			const auto twosCarry   = _mm_or_si128(_mm_and_si128(aboveTwos, belowTwos), _mm_and_si128(sideTwos, twosXor));
+
+			const auto twos        = _mm_xor_si128(twosPartial, onesCarry);
+			const auto foursOrMore = _mm_or_si128(twosCarry, _mm_and_si128(twosPartial, onesCarry));
+
+			const auto next = _mm_and_si128(_mm_andnot_si128(foursOrMore, twos), _mm_or_si128(ones, center));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(result + i), next);
+		}
+		StepRowsScalar(west + i, middle + i, east + i, result + i, count - i);
+	}
+
+	GOL_TARGET("avx2")
+	static void StepRowsAVX2(
+		const uint64_t* west, const uint64_t* middle, const uint64_t* east,
+		uint64_t* result, size_t count)
+	{
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const auto westAbove = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(west + i));
+			const auto above     = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(middle + i));
+			const auto eastAbove = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(east + i));
+			const auto westSide  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(west + i + 1));
+			const auto center    = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(middle + i + 1));
+			const auto eastSide  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(east + i + 1));
+			const auto westBelow = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(west + i + 2));
+			const auto below     = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(middle + i + 2));
+			const auto eastBelow = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(east + i + 2));
+
+			const auto aboveXor  = _mm256_xor_si256(westAbove, above);
+			const auto aboveOnes = _mm256_xor_si256(aboveXor, eastAbove);
+			const auto aboveTwos = _mm256_or_si256(_mm256_and_si256(westAbove, above), _mm256_and_si256(eastAbove, aboveXor));
+
+			const auto belowXor  = _mm256_xor_si256(westBelow, below);
+			const auto belowOnes = _mm256_xor_si256(belowXor, eastBelow);
+			const auto belowTwos = _mm256_or_si256(_mm256_and_si256(westBelow, below), _mm256_and_si256(eastBelow, belowXor));
+
+			const auto sideOnes = _mm256_xor_si256(westSide, eastSide);
+			const auto sideTwos = _mm256_and_si256(westSide, eastSide);
+
+			const auto onesXor   = _mm256_xor_si256(aboveOnes, belowOnes);
+			const auto ones      = _mm256_xor_si256(onesXor, sideOnes);
+			const auto onesCarry = _mm256_or_si256(_mm256_and_si256(aboveOnes, belowOnes), _mm256_and_si256(sideOnes, onesXor));
+
+			const auto twosXor     = _mm256_xor_si256(aboveTwos, belowTwos);
+			const auto twosPartial = _mm256_xor_si256(twosXor, sideTwos);
+			const auto twosCarry   = _mm256_or_si256(_mm256_and_si256(aboveTwos, belowTwos), _mm256_and_si256(sideTwos, twosXor));
+
+			const auto twos        = _mm256_xor_si256(twosPartial, onesCarry);
+			const auto foursOrMore = _mm256_or_si256(twosCarry, _mm256_and_si256(twosPartial, onesCarry));
+
+			const auto next = _mm256_and_si256(_mm256_andnot_si256(foursOrMore, twos), _mm256_or_si256(ones, center));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(result + i), next);
+		}
+		StepRowsScalar(west + i, middle + i, east + i, result + i, count - i);
+	}
+
+	GOL_TARGET("avx512f")
+	static void StepRowsAVX512(
+		const uint64_t* west, const uint64_t* middle, const uint64_t* east,
+		uint64_t* result, size_t count)
+	{
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const auto westAbove = _mm512_loadu_si512(west + i);
+			const auto above     = _mm512_loadu_si512(middle + i);
+			const auto eastAbove = _mm512_loadu_si512(east + i);
+			const auto westSide  = _mm512_loadu_si512(west + i + 1);
+			const auto center    = _mm512_loadu_si512(middle + i + 1);
+			const auto eastSide  = _mm512_loadu_si512(east + i + 1);
+			const auto westBelow = _mm512_loadu_si512(west + i + 2);
+			const auto below     = _mm512_loadu_si512(middle + i + 2);
+			const auto eastBelow = _mm512_loadu_si512(east + i + 2);
+
+			// Ternary logic evaluates each three-input adder term in a single instruction:
+			// 0x96 is a ^ b ^ c and 0xE8 is the majority function used for carries
+			const auto aboveOnes = _mm512_ternarylogic_epi64(westAbove, above, eastAbove, 0x96);
+			const auto aboveTwos = _mm512_ternarylogic_epi64(westAbove, above, eastAbove, 0xE8);
+
+			const auto belowOnes = _mm512_ternarylogic_epi64(westBelow, below, eastBelow, 0x96);
+			const auto belowTwos = _mm512_ternarylogic_epi64(westBelow, below, eastBelow, 0xE8);
+
+			const auto sideOnes = _mm512_xor_si512(westSide, eastSide);
+			const auto sideTwos = _mm512_and_si512(westSide, eastSide);
+
+			const auto ones      = _mm512_ternarylogic_epi64(aboveOnes, belowOnes, sideOnes, 0x96);
+			const auto onesCarry = _mm512_ternarylogic_epi64(aboveOnes, belowOnes, sideOnes, 0xE8);
+
+			const auto twosPartial = _mm512_ternarylogic_epi64(aboveTwos, belowTwos, sideTwos, 0x96);
+			const auto twosCarry   = _mm512_ternarylogic_epi64(aboveTwos, belowTwos, sideTwos, 0xE8);
+
+			const auto twos        = _mm512_xor_si512(twosPartial, onesCarry);
+			const auto foursOrMore = _mm512_or_si512(twosCarry, _mm512_and_si512(twosPartial, onesCarry));
+
+			const auto next = _mm512_and_si512(_mm512_andnot_si512(foursOrMore, twos), _mm512_or_si512(ones, center));
+			_mm512_storeu_si512(result + i, next);
+		}
+		StepRowsScalar(west + i, middle + i, east + i, result + i, count - i);
+	}
+
+	#if defined(_MSC_VER) && !defined(__clang__)
+	static bool CpuSupports(KernelIsa isa)
+	{
+		std::array<int32_t, 4> info {};
+		__cpuid(info.data(), 0);
+		const auto maxLeaf = info[0];
+
+		__cpuid(info.data(), 1);
+		const bool sse2 = (info[3] & (1 << 26)) != 0;
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		if (isa == KernelIsa::SSE2)
+			return sse2;
+		if (!osxsave || !avx || maxLeaf < 7)
+			return false;
+
+		const auto xcr0 = _xgetbv(0);
+		__cpuidex(info.data(), 7, 0);
+		if (isa == KernelIsa::AVX2)
+			return (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0;
+		return (xcr0 & 0xE6) == 0xE6 && (info[1] & (1 << 16)) != 0;
+	}
+	#else
+	static bool CpuSupports(KernelIsa isa)
+	{
+		__builtin_cpu_init();
+		switch (isa)
+		{
+		case KernelIsa::SSE2:
+			return __builtin_cpu_supports("sse2");
+		case KernelIsa::AVX2:
+			return __builtin_cpu_supports("avx2");
+		case KernelIsa::AVX512:
+			return __builtin_cpu_supports("avx512f");
+		default:
+			return true;
+		}
+	}
+	#endif
+#endif
+
+	static constexpr std::array KernelIsas = { KernelIsa::Scalar, KernelIsa::SSE2, KernelIsa::AVX2, KernelIsa::AVX512 };
+
+	static std::atomic<KernelIsa>& ActiveIsa()
+	{
+		static std::atomic<KernelIsa> active { LifeKernel::Detect() };
+		return active;
+	}
+
+	KernelIsa LifeKernel::Detect()
+	{
+		for (auto itr = KernelIsas.rbegin(); itr != KernelIsas.rend(); ++itr)
+		{
+			if (Supported(*itr))
+				return *itr;
+		}
+		return KernelIsa::Scalar;
+	}
+
+	bool LifeKernel::Supported(KernelIsa isa)
+	{
+		if (isa == KernelIsa::Scalar)
+			return true;
+#ifdef GOL_KERNEL_X86
+		return CpuSupports(isa);
+#else
+		return false;
+#endif
+	}
+
+	KernelIsa LifeKernel::Active()
+	{
+		return ActiveIsa().load(std::memory_order_relaxed);
+	}
+
+	bool LifeKernel::SetActive(KernelIsa isa)
+	{
+		if (!Supported(isa))
+			return false;
+		ActiveIsa().store(isa, std::memory_order_relaxed);
+		return true;
+	}
+
+	std::string_view LifeKernel::ToString(KernelIsa isa)
+	{
+		switch (isa)
+		{
+		case KernelIsa::Scalar:
+			return "Scalar";
+		case KernelIsa::SSE2:
+			return "SSE2";
+		case KernelIsa::AVX2:
+			return "AVX2";
+		case KernelIsa::AVX512:
+			return "AVX-512";
+		}
+		return "Unknown";
+	}
+
+	LifeKernelFunction LifeKernel::Get(KernelIsa isa)
+	{
+		switch (isa)
+		{
+#ifdef GOL_KERNEL_X86
+		case KernelIsa::SSE2:
+			return &StepRowsSSE2;
+		case KernelIsa::AVX2:
+			return &StepRowsAVX2;
+		case KernelIsa::AVX512:
+			return &StepRowsAVX512;
+#endif
+		default:
+			return &StepRowsScalar;
+		}
+	}
+
+	void LifeKernel::StepRows(
+		const uint64_t* west, const uint64_t* middle, const uint64_t* east,
+		uint64_t* result, size_t count)
+	{
+		static const std::array kernels = { Get(KernelIsas[0]), Get(KernelIsas[1]), Get(KernelIsas[2]), Get(KernelIsas[3]) };
+		kernels[static_cast<size_t>(Active())](west, middle, east, result, count);
+	}
+
+	void LifeKernel::StepRows(
+		const uint64_t* west, const uint64_t* middle, const uint64_t* east,
+		uint64_t* result, size_t count, const LifeRule& rule)
+	{
+		if (rule == LifeRules::Conway)
+			return StepRows(west, middle, east, result, count);
+
+		DispatchLifeRule(rule, [&](const auto& dispatched)
+		{
+			StepRowsForRule(west, middle, east, result, count, dispatched);
+		});
+	}
+}
\ No newline at end of file
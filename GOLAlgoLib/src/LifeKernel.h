@@ -0,0 +1,55 @@
+#ifndef __LifeKernel_h__
+#define __LifeKernel_h__
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "LifeRule.h"
+
+namespace gol
+{
+	enum class KernelIsa
+	{
+		Scalar,
+		SSE2,
+		AVX2,
+		AVX512
+	};
+
+	// Computes `count` rows of the next generation, 64 cells per row. The inputs hold count + 2 rows
+	// where index i is row i - 1, so every output row can read the rows directly above and below it.
+	// `west` and `east` are the middle rows shifted so that each bit lines up with that neighbor.
+	using LifeKernelFunction = void (*)(
+		const uint64_t* west, const uint64_t* middle, const uint64_t* east,
+		uint64_t* result, size_t count);
+
+	namespace LifeKernel
+	{
+		// Best instruction set supported by both the CPU and the operating system
+		KernelIsa Detect();
+
+		bool Supported(KernelIsa isa);
+
+		KernelIsa Active();
+
+		// Forces a specific kernel, returning false and leaving the active kernel unchanged if unsupported
+		bool SetActive(KernelIsa isa);
+
+		std::string_view ToString(KernelIsa isa);
+
+		LifeKernelFunction Get(KernelIsa isa);
+
+		void StepRows(
+			const uint64_t* west, const uint64_t* middle, const uint64_t* east,
+			uint64_t* result, size_t count);
+
+		// Conway's rule runs on the active kernel above. Other rules count every neighbor total
+		// bit-sliced and match the counts against the rule.
+		void StepRows(
+			const uint64_t* west, const uint64_t* middle, const uint64_t* east,
+			uint64_t* result, size_t count, const LifeRule& rule);
+	}
+}
+
+#endif
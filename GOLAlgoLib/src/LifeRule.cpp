@@ -0,0 +1,62 @@
+#include <cctype>
+#include <cstdint>
+#include <expected>
+#include <format>
+#include <string>
+#include <string_view>
+
+#include "LifeRule.h"
+
+namespace gol
+{
+	std::expected<LifeRule, std::string> LifeRule::Parse(std::string_view rule)
+	{
+		const auto separator = rule.find('/');
+		if (separator == std::string_view::npos)
+			return std::unexpected { std::format("Rule \"{}\" is missing the '/' between births and survivals.", rule) };
+
+		const auto parseCounts = [rule](std::string_view part, char prefix) -> std::expected<uint16_t, std::string>
+		{
+			if (part.empty() || std::toupper(static_cast<unsigned char>(part.front())) != prefix)
+				return std::unexpected { std::format("Rule \"{}\" is not in B/S notation.", rule) };
+
+			uint16_t counts = 0;
+			for (auto digit : part.substr(1))
+			{
+				if (digit < '0' || digit > '8')
+					return std::unexpected { std::format("Rule \"{}\" has an invalid neighbor count '{}'.", rule, digit) };
+				counts |= static_cast<uint16_t>(1 << (digit - '0'));
+			}
+			return counts;
+		};
+
+		const auto birth = parseCounts(rule.substr(0, separator), 'B');
+		if (!birth)
+			return std::unexpected { birth.error() };
+		const auto survival = parseCounts(rule.substr(separator + 1), 'S');
+		if (!survival)
+			return std::unexpected { survival.error() };
+
+		if (*birth & 1)
+			return std::unexpected { std::format("Rule \"{}\" brings empty space to life, which is not supported.", rule) };
+
+		return LifeRule { .Birth = *birth, .Survival = *survival };
+	}
+
+	std::string LifeRule::ToString() const
+	{
+		std::string result = "B";
+		for (int32_t neighbors = 0; neighbors <= 8; neighbors++)
+		{
+			if (Born(neighbors))
+				result += static_cast<char>('0' + neighbors);
+		}
+		result += "/S";
+		for (int32_t neighbors = 0; neighbors <= 8; neighbors++)
+		{
+			if (Survives(neighbors))
+				result += static_cast<char>('0' + neighbors);
+		}
+		return result;
+	}
+}
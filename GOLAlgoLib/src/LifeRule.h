@@ -0,0 +1,62 @@
+#ifndef __LifeRule_h__
+#define __LifeRule_h__
+
+#include <cstdint>
+#include <expected>
+#include <string>
+#include <string_view>
+
+namespace gol
+{
+	// A Life-like rule in B/S notation. Bit n of Birth is set when a dead cell with n live neighbors
+	// comes alive, and bit n of Survival when a live cell with n live neighbors stays alive.
+	struct LifeRule
+	{
+		uint16_t Birth = 1 << 3;
+		uint16_t Survival = (1 << 2) | (1 << 3);
+
+		constexpr bool Born(int32_t neighbors) const { return (Birth >> neighbors) & 1; }
+		constexpr bool Survives(int32_t neighbors) const { return (Survival >> neighbors) & 1; }
+
+		// Parses rules like "B36/S23". B0 is rejected, since every engine relies on empty space staying empty.
+		static std::expected<LifeRule, std::string> Parse(std::string_view rule);
+
+		std::string ToString() const;
+
+		constexpr bool operator==(const LifeRule&) const = default;
+	};
+
+	namespace LifeRules
+	{
+		inline constexpr LifeRule Conway      { .Birth = 0b000001000, .Survival = 0b000001100 };
+		inline constexpr LifeRule HighLife    { .Birth = 0b001001000, .Survival = 0b000001100 };
+		inline constexpr LifeRule DayAndNight { .Birth = 0b111001000, .Survival = 0b111011000 };
+		inline constexpr LifeRule Seeds       { .Birth = 0b000000100, .Survival = 0b000000000 };
+	}
+
+	// A rule fixed at compile time, so engines stepped with it fold every transition into constants
+	template <LifeRule Rule>
+	struct StaticLifeRule
+	{
+		static constexpr bool Born(int32_t neighbors) { return Rule.Born(neighbors); }
+		static constexpr bool Survives(int32_t neighbors) { return Rule.Survives(neighbors); }
+	};
+
+	// Calls step with a StaticLifeRule for the common rules and with the rule itself otherwise, so the
+	// same stepping template serves both
+	template <typename Function>
+	decltype(auto) DispatchLifeRule(const LifeRule& rule, Function&& step)
+	{
+		if (rule == LifeRules::Conway)
+			return step(StaticLifeRule<LifeRules::Conway> {});
+		if (rule == LifeRules::HighLife)
+			return step(StaticLifeRule<LifeRules::HighLife> {});
+		if (rule == LifeRules::DayAndNight)
+			return step(StaticLifeRule<LifeRules::DayAndNight> {});
+		if (rule == LifeRules::Seeds)
+			return step(StaticLifeRule<LifeRules::Seeds> {});
+		return step(rule);
+	}
+}
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef __LifeTileMap_h__
+#define __LifeTileMap_h__
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <unordered_dense.h>
+#include <vector>
+
+#include "Graphics2D.h"
+#include "LifeHashSet.h"
+#include "LifeRule.h"
+#include "ThreadPool.h"
+
+namespace gol
+{
+    // A 64x64 block of cells. Bit x of row y is the cell at (x, y) relative to the tile's corner.
+    struct LifeTile
+    {
+        static constexpr int32_t Size = 64;
+
+        using RowArray = std::array<uint64_t, Size>;
+
+        // Generations alternate between the two buffers, so the other buffer holds the generation
+        // before the current one. When nothing around a tile differs from two generations ago, its
+        // next generation is already sitting in the other buffer and the tile is left untouched.
+        std::array<RowArray, 2> Buffers {};
+
+        // Which tiles of the 3x3 neighborhood can see cells that differ from two generations ago,
+        // indexed like a neighborhood with the tile itself at bit 4
+        uint16_t ChangeMask = AllChanged;
+
+        static constexpr uint16_t AllChanged = 0x1FF;
+
+        static bool Empty(const RowArray& rows);
+        static int64_t Population(const RowArray& rows);
+
+        static uint16_t ChangeMaskOf(const RowArray& next, const RowArray& before);
+    };
+
+    class LifeTileMap
+    {
+    public:
+        using TileMap = ankerl::unordered_dense::map<Vec2, LifeTile>;
+
+        class ConstIterator
+        {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using difference_type   = std::ptrdiff_t;
+            using value_type        = Vec2;
+            using pointer           = const value_type*;
+            using reference         = const value_type&;
+
+            ConstIterator() = default;
+
+            ConstIterator& operator++();
+            ConstIterator operator++(int);
+
+            bool operator==(const ConstIterator& other) const;
+            bool operator!=(const ConstIterator& other) const { return !(*this == other); }
+
+            reference operator*() const { return m_Current; }
+            pointer operator->() const { return &m_Current; }
+        private:
+            friend LifeTileMap;
+
+            ConstIterator(TileMap::const_iterator tile, TileMap::const_iterator end, int32_t buffer);
+            void AdvanceToNext();
+        private:
+            TileMap::const_iterator m_Tile {};
+            TileMap::const_iterator m_End {};
+            int32_t m_Buffer = 0;
+            int32_t m_Row = 0;
+            uint64_t m_RemainingBits = 0;
+            Vec2 m_Current {};
+        };
+    public:
+        LifeTileMap() = default;
+        LifeTileMap(const LifeHashSet& cells);
+
+        // Tiles are kept for two generations after dying to remember their history
+        bool empty() const;
+
+        ConstIterator begin() const;
+        ConstIterator end() const;
+
+        int64_t Population() const;
+
+        const LifeRule& Rule() const { return m_Rule; }
+        void SetRule(const LifeRule& rule);
+
+        // Tiles are split across the pool when one is given
+        void Advance(const Rect& bounds, ThreadPool* pool = nullptr);
+
+        static constexpr Vec2 TilePos(Vec2 cell) { return { cell.X >> 6, cell.Y >> 6 }; }
+    private:
+        static constexpr size_t ParallelGrainSize = 16;
+
+        // Center tile at index 4, row-major from the north-west corner
+        using Neighborhood = std::array<const LifeTile*, 9>;
+
+        struct TileUpdate
+        {
+            Vec2 Pos;
+            LifeTile::RowArray Rows;
+            uint16_t ChangeMask;
+        };
+
+        TileUpdate UpdateTile(Vec2 tilePos, const Rect& bounds) const;
+        void ApplyUpdates(std::span<const TileUpdate> updates);
+
+        void ResetHistory();
+
+        Neighborhood FindNeighborhood(Vec2 tilePos) const;
+        LifeTile::RowArray AdvanceTile(const Neighborhood& neighborhood) const;
+
+        const LifeTile* FindTile(Vec2 tilePos) const;
+
+        static void ClipToBounds(LifeTile::RowArray& rows, Vec2 tilePos, const Rect& bounds);
+    private:
+        TileMap m_Tiles {};
+
+        // Index of the buffer holding the current generation in every tile
+        int32_t m_Buffer = 0;
+
+        // Tiles that differ from two generations ago. Only these and the neighbors in their change masks can change next.
+        std::vector<Vec2> m_ActiveTiles {};
+
+        // The other buffers only hold real generations once the map has been stepped under the same bounds
+        bool m_HistoryValid = false;
+        Rect m_Bounds {};
+
+        LifeRule m_Rule {};
+    };
+}
+
+#endif
@@ -0,0 +1,27 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+#include "SimulationClock.h"
+
+gol::SimulationClock::SimulationClock(Duration tick, Duration maxCatchUp)
+	: m_Tick(std::max(tick, Duration { 1 }))
+	, m_MaxCatchUp(maxCatchUp)
+{ }
+
+void gol::SimulationClock::SetTick(Duration tick)
+{
+	m_Tick = std::max(tick, Duration { 1 });
+	Reset();
+}
+
+uint64_t gol::SimulationClock::Advance(Duration elapsed)
+{
+	// Always allow one tick, so ticks longer than the cap still happen
+	const auto limit = std::max(m_MaxCatchUp, m_Tick);
+	m_Accumulated = std::min(m_Accumulated + std::max(elapsed, Duration::zero()), limit);
+
+	const auto ticks = m_Accumulated / m_Tick;
+	m_Accumulated -= ticks * m_Tick;
+	return static_cast<uint64_t>(ticks);
+}
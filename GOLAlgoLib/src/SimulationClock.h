@@ -0,0 +1,40 @@
+#ifndef __SimulationClock_h__
+#define __SimulationClock_h__
+
+#include <chrono>
+#include <cstdint>
+
+namespace gol
+{
+	// Turns elapsed time into ticks at a fixed rate. Time short of a whole tick carries over to the
+	// next call, so the rate holds exactly over long runs however the calls are spaced. A clock that
+	// falls behind runs every tick it owes at once, but never more than MaxCatchUp worth. Anything
+	// older is dropped, so a simulation that cannot keep up slows down instead of falling further
+	// behind with every catch-up.
+	class SimulationClock
+	{
+	public:
+		using Duration = std::chrono::nanoseconds;
+
+		static constexpr Duration DefaultMaxCatchUp = std::chrono::milliseconds { 250 };
+	public:
+		explicit SimulationClock(Duration tick, Duration maxCatchUp = DefaultMaxCatchUp);
+
+		// Changing the rate drops any partial tick
+		void SetTick(Duration tick);
+		Duration Tick() const { return m_Tick; }
+
+		// Adds the elapsed time and returns how many ticks are due
+		uint64_t Advance(Duration elapsed);
+
+		Duration UntilNextTick() const { return m_Tick - m_Accumulated; }
+
+		void Reset() { m_Accumulated = Duration::zero(); }
+	private:
+		Duration m_Tick;
+		Duration m_MaxCatchUp;
+		Duration m_Accumulated = Duration::zero();
+	};
+}
+
+#endif
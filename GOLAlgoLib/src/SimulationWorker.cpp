@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <utility>
+#include <variant>
+
+#include "GameGrid.h"
+#include "Graphics2D.h"
+#include "SimulationClock.h"
+#include "SimulationWorker.h"
+
+std::span<const gol::Vec2> gol::GenerationSnapshot::CellsInColumns(int32_t left, int32_t right) const
+{
+	const auto first = std::ranges::lower_bound(Cells, left, {}, &Vec2::X);
+	const auto last = std::ranges::lower_bound(first, Cells.end(), right, {}, &Vec2::X);
+	return { first, last };
+}
+
+gol::SimulationWorker::SimulationWorker()
+	: m_Thread([this](std::stop_token stop) { Run(stop); })
+{ }
+
+void gol::SimulationWorker::Start(GameGrid grid)
+{
+	Publish(grid);
+	m_HoldsGrid = true;
+	Send(StartCommand { std::move(grid) });
+}
+
+void gol::SimulationWorker::Step(GameGrid grid, uint64_t generations)
+{
+	Publish(grid);
+	m_HoldsGrid = true;
+	Send(StepCommand { std::move(grid), generations });
+}
+
+void gol::SimulationWorker::Pause()
+{
+	Send(PauseCommand {});
+}
+
+void gol::SimulationWorker::SetTickDelay(double milliseconds)
+{
+	Send(DelayCommand { milliseconds });
+}
+
+void gol::SimulationWorker::SetFrameBudget(double milliseconds)
+{
+	Send(BudgetCommand { milliseconds });
+}
+
+std::optional<gol::GameGrid> gol::SimulationWorker::TryReclaim()
+{
+	std::lock_guard lock { m_Mutex };
+	if (!m_Returned)
+		return std::nullopt;
+
+	m_HoldsGrid = false;
+	return std::exchange(m_Returned, std::nullopt);
+}
+
+void gol::SimulationWorker::Send(Command command)
+{
+	{
+		std::lock_guard lock { m_Mutex };
+		m_Commands.push_back(std::move(command));
+	}
+	m_Wake.notify_one();
+}
+
+void gol::SimulationWorker::Publish(const GameGrid& grid, double generationsPerSecond)
+{
+	// Refills a slot the owner has finished with, reusing its buffer
+	auto& snapshot = m_Snapshots.Back();
+	snapshot.Cells.assign(grid.SortedData().begin(), grid.SortedData().end());
+	snapshot.Generation = grid.Generation();
+	snapshot.Population = grid.Population();
+	snapshot.Period = grid.DetectedPeriod();
+	snapshot.GenerationsPerSecond = generationsPerSecond;
+	m_Snapshots.Publish();
+}
+
+void gol::SimulationWorker::HandBack(std::optional<GameGrid>& grid)
+{
+	std::lock_guard lock { m_Mutex };
+	m_Returned = std::move(grid);
+	grid.reset();
+}
+
+// A batch costs about the same however long it is once a cycle has been found, and only grows
+// logarithmically with HashLife jumps, so without a cap those batches would keep doubling
+static constexpr double MaxBatchSize = 1 << 30;
+
+// Scales the batch so the next one takes about the budget, by at most a factor of two at a time so
+// a single slow or fast batch cannot throw the size off
+static uint64_t NextBatchSize(uint64_t batch, std::chrono::duration<double> elapsed, std::chrono::duration<double> budget)
+{
+	const auto current = static_cast<double>(batch);
+	const auto scaled = elapsed.count() > 0
+		? std::clamp(current * (budget / elapsed), current / 2, current * 2)
+		: current * 2;
+	return static_cast<uint64_t>(std::clamp(scaled, 1., MaxBatchSize));
+}
+
+void gol::SimulationWorker::Run(std::stop_token stop)
+{
+	using Clock = std::chrono::steady_clock;
+	using Milliseconds = std::chrono::duration<double, std::milli>;
+	static constexpr auto RateWindow = std::chrono::milliseconds { 500 };
+
+	std::optional<GameGrid> grid;
+	bool running = false;
+	bool maxSpeed = true;
+	auto budget = Milliseconds { DefaultFrameBudgetMs };
+
+	// Only used with a tick delay
+	SimulationClock clock { std::chrono::milliseconds { 1 } };
+	auto lastTime = Clock::now();
+	auto wakeTime = Clock::now();
+
+	// Generations a step still has to go. Steps run in batches like max speed, so a long one
+	// publishes its progress and can be paused or stopped between batches.
+	uint64_t stepLeft = 0;
+
+	uint64_t batchSize = 1;
+	double generationsPerSecond = 0;
+	auto windowStart = Clock::now();
+	int64_t windowGeneration = 0;
+
+	while (!stop.stop_requested())
+	{
+		std::deque<Command> commands;
+		{
+			std::unique_lock lock { m_Mutex };
+			const auto pending = [this] { return !m_Commands.empty(); };
+			if (running || stepLeft > 0)
+				m_Wake.wait_until(lock, stop, wakeTime, pending);
+			else
+				m_Wake.wait(lock, stop, pending);
+			commands.swap(m_Commands);
+		}
+
+		for (auto& command : commands)
+		{
+			if (auto* start = std::get_if<StartCommand>(&command))
+			{
+				grid = std::move(start->Grid);
+				running = true;
+				stepLeft = 0;
+				clock.Reset();
+				lastTime = Clock::now();
+				batchSize = 1;
+				generationsPerSecond = 0;
+				windowStart = Clock::now();
+				windowGeneration = grid->Generation();
+			}
+			else if (auto* step = std::get_if<StepCommand>(&command))
+			{
+				grid = std::move(step->Grid);
+				running = false;
+				stepLeft = step->Generations;
+				batchSize = 1;
+				if (stepLeft == 0)
+					HandBack(grid);
+			}
+			else if (std::holds_alternative<PauseCommand>(command))
+			{
+				running = false;
+				stepLeft = 0;
+				if (grid)
+					HandBack(grid);
+			}
+			else if (auto* tickDelay = std::get_if<DelayCommand>(&command))
+			{
+				maxSpeed = tickDelay->Milliseconds <= 0;
+				if (!maxSpeed)
+					clock.SetTick(std::chrono::duration_cast<SimulationClock::Duration>(Milliseconds { tickDelay->Milliseconds }));
+			}
+			else
+				budget = Milliseconds { std::get<BudgetCommand>(command).Milliseconds };
+		}
+
+		if (stepLeft > 0)
+		{
+			const auto batchStart = Clock::now();
+			const auto generations = std::min(batchSize, stepLeft);
+			grid->AdvanceBy(generations);
+			stepLeft -= generations;
+			batchSize = NextBatchSize(batchSize, Clock::now() - batchStart, budget);
+
+			Publish(*grid);
+			if (stepLeft == 0)
+				HandBack(grid);
+			wakeTime = batchStart;
+			continue;
+		}
+
+		if (!running)
+			continue;
+
+		// Every tick that came due since the last pass is run, so delays shorter than the time it
+		// takes to wake up are still honored on average
+		const auto batchStart = Clock::now();
+		const auto generations = maxSpeed ? batchSize : clock.Advance(batchStart - lastTime);
+		lastTime = batchStart;
+		if (generations > 0)
+		{
+			grid->AdvanceBy(generations);
+			const auto now = Clock::now();
+			if (maxSpeed)
+				batchSize = NextBatchSize(batchSize, now - batchStart, budget);
+
+			if (now - windowStart >= RateWindow)
+			{
+				const auto seconds = std::chrono::duration<double>(now - windowStart).count();
+				generationsPerSecond = static_cast<double>(grid->Generation() - windowGeneration) / seconds;
+				windowStart = now;
+				windowGeneration = grid->Generation();
+			}
+
+			Publish(*grid, generationsPerSecond);
+		}
+
+		// Measured from when the clock was last advanced, so time spent stepping counts towards the next tick
+		wakeTime = maxSpeed ? batchStart : lastTime + clock.UntilNextTick();
+	}
+}
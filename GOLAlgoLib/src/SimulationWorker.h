@@ -0,0 +1,110 @@
+#ifndef __SimulationWorker_h__
+#define __SimulationWorker_h__
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include "GameGrid.h"
+#include "Graphics2D.h"
+#include "TripleBuffer.h"
+
+namespace gol
+{
+	// A finished generation as the worker saw it. A snapshot is not touched again until the drawing
+	// thread has moved on to a newer one, so it can be read while the worker keeps stepping.
+	struct GenerationSnapshot
+	{
+		// Sorted by X, then Y
+		std::vector<Vec2> Cells;
+		int64_t Generation = 0;
+		int64_t Population = 0;
+		std::optional<int64_t> Period;
+
+		// Measured over the last half second of running, and 0 while paused
+		double GenerationsPerSecond = 0;
+
+		// Cells with left <= X < right, the only ones a region spanning those columns can contain
+		std::span<const Vec2> CellsInColumns(int32_t left, int32_t right) const;
+	};
+
+	// Steps a grid on its own thread, so a slow generation never holds up the thread drawing it.
+	// The owner hands the grid over with Start or Step and controls the worker through a queue of
+	// commands. Once paused, the worker hands the grid back through TryReclaim. No call waits for
+	// a generation to finish.
+	//
+	// With a tick delay of 0 the worker runs flat out. It then advances the grid in batches sized so
+	// that each batch takes about the frame budget, which lets large HashLife jumps and cycle
+	// fast-forwards do the work while the owner still sees a new generation every frame or so.
+	class SimulationWorker
+	{
+	public:
+		static constexpr double DefaultFrameBudgetMs = 12.;
+	public:
+		SimulationWorker();
+
+		SimulationWorker(const SimulationWorker&) = delete;
+		SimulationWorker& operator=(const SimulationWorker&) = delete;
+
+		// Steps the grid once per tick delay until paused, catching up on ticks it woke too late for
+		void Start(GameGrid grid);
+
+		// Advances the grid by a number of generations, then hands it back. Long steps run in batches
+		// of about the frame budget, publishing each one.
+		void Step(GameGrid grid, uint64_t generations);
+
+		// Stops after the batch in progress and hands the grid back, part way through a step if need be
+		void Pause();
+
+		void SetTickDelay(double milliseconds);
+		void SetFrameBudget(double milliseconds);
+
+		// True from Start or Step until the grid has been reclaimed
+		bool HoldsGrid() const { return m_HoldsGrid; }
+		std::optional<GameGrid> TryReclaim();
+
+		// Picks up the newest generation, dropping any the owner never got to see. Handing the grid
+		// over publishes it as the first generation.
+		const GenerationSnapshot& AcquireLatest() { return m_Snapshots.Acquire(); }
+		bool HasNewGeneration() const { return m_Snapshots.HasFresh(); }
+
+		// The generation picked up last
+		const GenerationSnapshot& Latest() const { return m_Snapshots.Front(); }
+	private:
+		struct StartCommand { GameGrid Grid; };
+		struct StepCommand { GameGrid Grid; uint64_t Generations; };
+		struct PauseCommand { };
+		struct DelayCommand { double Milliseconds; };
+		struct BudgetCommand { double Milliseconds; };
+		using Command = std::variant<StartCommand, StepCommand, PauseCommand, DelayCommand, BudgetCommand>;
+
+		void Send(Command command);
+		void Publish(const GameGrid& grid, double generationsPerSecond = 0.);
+		void HandBack(std::optional<GameGrid>& grid);
+
+		void Run(std::stop_token stop);
+	private:
+		mutable std::mutex m_Mutex;
+		std::condition_variable_any m_Wake;
+		std::deque<Command> m_Commands;
+		std::optional<GameGrid> m_Returned;
+
+		// Produced by whichever thread holds the grid, so handing the grid over also hands over publishing
+		TripleBuffer<GenerationSnapshot> m_Snapshots;
+
+		// Only used by the owning thread
+		bool m_HoldsGrid = false;
+
+		// Declared last, so the thread is stopped before the state it uses is destroyed
+		std::jthread m_Thread;
+	};
+}
+
+#endif
@@ -0,0 +1,238 @@
+#ifndef __SlabArena_h__
+#define __SlabArena_h__
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace gol
+{
+    inline constexpr size_t CacheLineSize = 64;
+
+    // Hands out objects from large slabs instead of allocating them one at a time. Slots are padded
+    // to a power of two so no object straddles a cache line, and every object stays at a fixed
+    // address until it is destroyed. Objects can also be addressed by a dense index, which is how
+    // HashLife nodes refer to each other. Destroyed slots are reused by later objects, and slabs are
+    // only released when the whole arena is, so objects must be trivially destructible.
+    //
+    // Emplace and Destroy need external synchronization, while EmplaceConcurrent and
+    // DestroyConcurrent may be called from many threads at once. Other threads may read objects
+    // meanwhile, as long as they learned the index through something that synchronizes with its
+    // creation. The directory of slabs is never resized in place for that reason. It is copied into
+    // a larger one, and the old copies are kept until the arena is released.
+    template <typename T>
+    class SlabArena
+    {
+    public:
+        static_assert(std::is_trivially_destructible_v<T>, "SlabArena never runs destructors");
+
+        struct Stats
+        {
+            size_t Objects = 0;
+            size_t FreeSlots = 0;
+            size_t Slabs = 0;
+            size_t BytesUsed = 0;
+            size_t BytesReserved = 0;
+        };
+
+        static constexpr size_t DefaultObjectsPerSlab = 16384;
+    public:
+        // Slab sizes are rounded up to a power of two so indices split into a slab and an offset with a shift
+        explicit SlabArena(size_t objectsPerSlab = DefaultObjectsPerSlab)
+            : m_SlabShift(static_cast<int32_t>(std::bit_width(std::bit_ceil(objectsPerSlab > 0 ? objectsPerSlab : 1))) - 1)
+            , m_ObjectsPerSlab(size_t { 1 } << m_SlabShift)
+        { }
+
+        SlabArena(const SlabArena&) = delete;
+        SlabArena& operator=(const SlabArena&) = delete;
+
+        SlabArena(SlabArena&& other) noexcept
+            : m_Slabs(std::move(other.m_Slabs))
+            , m_Directories(std::move(other.m_Directories))
+            , m_Directory(other.m_Directory.exchange(nullptr, std::memory_order_relaxed))
+            , m_DirectoryCapacity(std::exchange(other.m_DirectoryCapacity, 0))
+            , m_SlabCount(other.m_SlabCount.exchange(0, std::memory_order_relaxed))
+            , m_Extent(other.m_Extent.exchange(0, std::memory_order_relaxed))
+            , m_FreeSlots(std::move(other.m_FreeSlots))
+            , m_SlabShift(other.m_SlabShift)
+            , m_ObjectsPerSlab(other.m_ObjectsPerSlab)
+        { }
+
+        SlabArena& operator=(SlabArena&& other) noexcept
+        {
+            m_Slabs = std::move(other.m_Slabs);
+            m_Directories = std::move(other.m_Directories);
+            m_Directory.store(other.m_Directory.exchange(nullptr, std::memory_order_relaxed), std::memory_order_relaxed);
+            m_DirectoryCapacity = std::exchange(other.m_DirectoryCapacity, 0);
+            m_SlabCount.store(other.m_SlabCount.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+            m_Extent.store(other.m_Extent.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+            m_FreeSlots = std::move(other.m_FreeSlots);
+            m_SlabShift = other.m_SlabShift;
+            m_ObjectsPerSlab = other.m_ObjectsPerSlab;
+            return *this;
+        }
+
+        template <typename... Args>
+        T* Create(Args&&... args)
+        {
+            return &(*this)[Emplace(std::forward<Args>(args)...)];
+        }
+
+        // Creates an object and returns its index
+        template <typename... Args>
+        size_t Emplace(Args&&... args)
+        {
+            size_t index = 0;
+            if (!m_FreeSlots.empty())
+            {
+                index = m_FreeSlots.back();
+                m_FreeSlots.pop_back();
+            }
+            else
+            {
+                index = m_Extent.load(std::memory_order_relaxed);
+                m_Extent.store(index + 1, std::memory_order_relaxed);
+                EnsureSlab(index);
+            }
+
+            ::new (static_cast<void*>(SlotAt(index).Storage)) T(std::forward<Args>(args)...);
+            return index;
+        }
+
+        // Creates an object from any thread. Destroyed slots are left for Emplace, so concurrent
+        // threads only ever contend on the end of the arena.
+        template <typename... Args>
+        size_t EmplaceConcurrent(Args&&... args)
+        {
+            const auto index = m_Extent.fetch_add(1, std::memory_order_relaxed);
+            EnsureSlab(index);
+            ::new (static_cast<void*>(SlotAt(index).Storage)) T(std::forward<Args>(args)...);
+            return index;
+        }
+
+        // Returns an object's slot to the arena for reuse
+        void Destroy(size_t index)
+        {
+            m_FreeSlots.push_back(index);
+        }
+
+        void DestroyConcurrent(size_t index)
+        {
+            std::lock_guard lock { m_Mutex };
+            m_FreeSlots.push_back(index);
+        }
+
+        T& operator[](size_t index) { return *std::launder(reinterpret_cast<T*>(SlotAt(index).Storage)); }
+        const T& operator[](size_t index) const { return *std::launder(reinterpret_cast<const T*>(SlotAt(index).Storage)); }
+
+        // One past the highest index handed out so far
+        size_t Extent() const
+        {
+            return m_Extent.load(std::memory_order_relaxed);
+        }
+
+        // Releases every object at once
+        void Clear()
+        {
+            m_Slabs.clear();
+            m_Directories.clear();
+            m_Directory.store(nullptr, std::memory_order_relaxed);
+            m_DirectoryCapacity = 0;
+            m_SlabCount.store(0, std::memory_order_relaxed);
+            m_Extent.store(0, std::memory_order_relaxed);
+            m_FreeSlots.clear();
+        }
+
+        size_t size() const
+        {
+            return Extent() - m_FreeSlots.size();
+        }
+
+        Stats MemoryStats() const
+        {
+            return
+            {
+                .Objects = size(),
+                .FreeSlots = m_FreeSlots.size(),
+                .Slabs = m_Slabs.size(),
+                .BytesUsed = size() * sizeof(Slot),
+                .BytesReserved = m_Slabs.size() * m_ObjectsPerSlab * sizeof(Slot)
+            };
+        }
+    private:
+        static constexpr size_t SlotAlignment = std::max(std::min(std::bit_ceil(sizeof(T)), CacheLineSize), alignof(T));
+
+        struct alignas(SlotAlignment) Slot
+        {
+            std::byte Storage[sizeof(T)];
+        };
+
+        Slot& SlotAt(size_t index) const
+        {
+            return m_Directory.load(std::memory_order_acquire)[index >> m_SlabShift][index & (m_ObjectsPerSlab - 1)];
+        }
+
+        // Adds slabs until the index is covered. Threads only take the lock when their index lies
+        // past the slabs published so far.
+        void EnsureSlab(size_t index)
+        {
+            const auto slab = index >> m_SlabShift;
+            if (slab < m_SlabCount.load(std::memory_order_acquire))
+                return;
+
+            std::lock_guard lock { m_Mutex };
+            while (m_Slabs.size() <= slab)
+                AddSlab();
+            m_SlabCount.store(m_Slabs.size(), std::memory_order_release);
+        }
+
+        void AddSlab()
+        {
+            if (m_Slabs.size() == m_DirectoryCapacity)
+            {
+                const auto capacity = std::max<size_t>(m_DirectoryCapacity * 2, 16);
+                auto directory = std::make_unique<Slot*[]>(capacity);
+                std::ranges::transform(m_Slabs, directory.get(), [](const auto& slab) { return slab.get(); });
+                m_Directory.store(directory.get(), std::memory_order_release);
+                m_Directories.push_back(std::move(directory));
+                m_DirectoryCapacity = capacity;
+            }
+
+            m_Slabs.emplace_back(static_cast<Slot*>(::operator new(
+                m_ObjectsPerSlab * sizeof(Slot), std::align_val_t { alignof(Slot) })));
+            m_Directory.load(std::memory_order_relaxed)[m_Slabs.size() - 1] = m_Slabs.back().get();
+        }
+
+        struct SlabDeleter
+        {
+            void operator()(Slot* slab) const { ::operator delete(slab, std::align_val_t { alignof(Slot) }); }
+        };
+    private:
+        std::vector<std::unique_ptr<Slot[], SlabDeleter>> m_Slabs {};
+
+        // The newest directory is the one in use, the rest may still be read by other threads
+        std::vector<std::unique_ptr<Slot*[]>> m_Directories {};
+        std::atomic<Slot**> m_Directory = nullptr;
+        size_t m_DirectoryCapacity = 0;
+
+        // Slabs visible to threads that skip the lock, and the next index that was never handed out
+        std::atomic<size_t> m_SlabCount = 0;
+        std::atomic<size_t> m_Extent = 0;
+
+        // Guards growing the arena and destroying objects concurrently
+        std::mutex m_Mutex {};
+        std::vector<size_t> m_FreeSlots {};
+        int32_t m_SlabShift;
+        size_t m_ObjectsPerSlab;
+    };
+}
+
+#endif
@@ -3,9 +3,13 @@
 #include "Graphics2D.h"
 #include "LifeAlgorithm.h"
 #include "LifeHashSet.h"
+#include "LifeRule.h"
 
-gol::LifeHashSet gol::SparseLife(std::span<const Vec2> data, const Rect& bounds)
+template <typename Rule>
+static gol::LifeHashSet SparseStep(std::span<const gol::Vec2> data, const gol::Rect& bounds, const Rule& rule)
 {
+	using namespace gol;
+
 	constexpr static std::array dx = { -1,-1,-1,0,0,1,1,1 };
 	constexpr static std::array dy = { -1,0,1,-1,1,-1,0,1 };
 
@@ -29,9 +33,27 @@ gol::LifeHashSet gol::SparseLife(std::span<const Vec2> data, const Rect& bounds)
 	newSet.reserve(neighborCount.size());
 	for (auto&& [pos, neighbors] : neighborCount)
 	{
-		if (neighbors == 3 || (neighbors == 2 && std::ranges::contains(data, pos)))
+		// Whether the cell is alive only matters for counts where birth and survival differ
+		const bool born = rule.Born(neighbors);
+		const bool survives = rule.Survives(neighbors);
+		if (born == survives ? born : std::ranges::contains(data, pos) == survives)
 			newSet.insert(pos);
 	}
 
+	// Cells without any live neighbors were never counted
+	if (rule.Survives(0))
+	{
+		for (auto&& pos : data)
+		{
+			if (!neighborCount.contains(pos))
+				newSet.insert(pos);
+		}
+	}
+
 	return newSet;
+}
+
+gol::LifeHashSet gol::SparseLife(std::span<const Vec2> data, const Rect& bounds, const LifeRule& rule)
+{
+	return DispatchLifeRule(rule, [&](const auto& dispatched) { return SparseStep(data, bounds, dispatched); });
 }
\ No newline at end of file
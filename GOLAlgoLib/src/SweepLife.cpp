@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Graphics2D.h"
+#include "LifeAlgorithm.h"
+#include "LifeRule.h"
+
+namespace gol
+{
+	// Flipping the sign bits makes unsigned comparison of the packed keys match
+	// the X-then-Y ordering of Vec2, which is the order std::set<Vec2> iterates in
+	static constexpr uint64_t PackKey(int32_t x, int32_t y)
+	{
+		return (static_cast<uint64_t>(static_cast<uint32_t>(x) ^ 0x8000'0000u) << 32)
+			| (static_cast<uint32_t>(y) ^ 0x8000'0000u);
+	}
+
+	static constexpr Vec2 UnpackKey(uint64_t key)
+	{
+		return
+		{
+			static_cast<int32_t>(static_cast<uint32_t>(key >> 32) ^ 0x8000'0000u),
+			static_cast<int32_t>(static_cast<uint32_t>(key) ^ 0x8000'0000u)
+		};
+	}
+
+	// Least significant digit first, one byte per pass. Coordinates of a pattern usually share their
+	// upper bytes, so passes where every key lands in the same bucket are skipped entirely.
+	static void RadixSort(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch)
+	{
+		constexpr size_t smallInput = 256;
+		constexpr int32_t passes = sizeof(uint64_t);
+		constexpr int32_t buckets = 256;
+
+		if (keys.size() <= smallInput)
+		{
+			std::ranges::sort(keys);
+			return;
+		}
+
+		std::array<std::array<size_t, buckets>, passes> counts {};
+		for (auto key : keys)
+		{
+			for (int32_t pass = 0; pass < passes; pass++)
+				counts[pass][(key >> (pass * 8)) & 0xFF]++;
+		}
+
+		scratch.resize(keys.size());
+		for (int32_t pass = 0; pass < passes; pass++)
+		{
+			auto& count = counts[pass];
+			if (std::ranges::contains(count, keys.size()))
+				continue;
+
+			size_t offset = 0;
+			for (auto& bucket : count)
+			{
+				const auto size = bucket;
+				bucket = offset;
+				offset += size;
+			}
+
+			for (auto key : keys)
+				scratch[count[(key >> (pass * 8)) & 0xFF]++] = key;
+			keys.swap(scratch);
+		}
+	}
+
+	template <typename Rule>
+	static std::vector<Vec2> SweepStep(std::span<const Vec2> data, const Rect& bounds, const Rule& rule)
+	{
+		constexpr static std::array dx = { -1,-1,-1,0,0,1,1,1 };
+		constexpr static std::array dy = { -1,0,1,-1,1,-1,0,1 };
+
+		const bool bounded = bounds.Width > 0 && bounds.Height > 0;
+
+		std::vector<uint64_t> scratch {};
+
+		std::vector<uint64_t> live {};
+		live.reserve(data.size());
+		for (auto pos : data)
+			live.push_back(PackKey(pos.X, pos.Y));
+		if (!std::ranges::is_sorted(live))
+			RadixSort(live, scratch);
+
+		// Every live cell adds one to each of its neighbors, so after sorting a cell's
+		// neighbor count is the length of the run of its key
+		std::vector<uint64_t> neighbors {};
+		neighbors.reserve(data.size() * dx.size());
+		for (auto pos : data)
+		{
+			for (size_t i = 0; i < dx.size(); i++)
+			{
+				const auto x = pos.X + dx[i];
+				const auto y = pos.Y + dy[i];
+				if (bounded && !bounds.InBounds(x, y))
+					continue;
+				neighbors.push_back(PackKey(x, y));
+			}
+		}
+		RadixSort(neighbors, scratch);
+
+		std::vector<Vec2> result {};
+		result.reserve(data.size());
+
+		auto liveItr = live.begin();
+		for (size_t i = 0; i < neighbors.size();)
+		{
+			const auto key = neighbors[i];
+			const auto runStart = i;
+			while (i < neighbors.size() && neighbors[i] == key)
+				i++;
+
+			const auto count = static_cast<int32_t>(i - runStart);
+			const bool born = rule.Born(count);
+			const bool survives = rule.Survives(count);
+			if (born == survives && !rule.Survives(0))
+			{
+				if (born)
+					result.push_back(UnpackKey(key));
+				continue;
+			}
+
+			// Runs come in ascending order, so the live set is walked only once. Live cells passed
+			// on the way have no live neighbors.
+			while (liveItr != live.end() && *liveItr < key)
+			{
+				if (rule.Survives(0))
+					result.push_back(UnpackKey(*liveItr));
+				++liveItr;
+			}
+
+			const bool alive = liveItr != live.end() && *liveItr == key;
+			if (alive)
+				++liveItr;
+			if (alive ? survives : born)
+				result.push_back(UnpackKey(key));
+		}
+
+		if (rule.Survives(0))
+		{
+			for (; liveItr != live.end(); ++liveItr)
+				result.push_back(UnpackKey(*liveItr));
+		}
+
+		return result;
+	}
+
+	std::vector<Vec2> SweepLife(std::span<const Vec2> data, const Rect& bounds, const LifeRule& rule)
+	{
+		return DispatchLifeRule(rule, [&](const auto& dispatched) { return SweepStep(data, bounds, dispatched); });
+	}
+}
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "ThreadPool.h"
+
+namespace gol
+{
+	// Lets a worker find its own deque, and lets threads outside the pool fall back to the shared one
+	thread_local const ThreadPool* t_CurrentPool = nullptr;
+	thread_local size_t t_CurrentQueue = 0;
+
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		const auto workerCount = std::max<uint32_t>(threadCount, 1) - 1;
+
+		// The final queue is shared by every thread outside the pool
+		for (uint32_t i = 0; i <= workerCount; i++)
+			m_Queues.push_back(std::make_unique<WorkerQueue>());
+
+		m_Workers.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; i++)
+			m_Workers.emplace_back([this, i] { WorkerLoop(i); });
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard lock { m_SleepMutex };
+			m_Stopping = true;
+		}
+		m_WakeCondition.notify_all();
+		m_Workers.clear();
+	}
+
+	uint32_t ThreadPool::DefaultThreadCount()
+	{
+		return std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	size_t ThreadPool::CurrentQueue()
+	{
+		return t_CurrentPool == this ? t_CurrentQueue : m_Workers.size();
+	}
+
+	void ThreadPool::Submit(TaskGroup& group, Task task)
+	{
+		group.m_Pending.fetch_add(1, std::memory_order_relaxed);
+
+		auto& queue = *m_Queues[CurrentQueue()];
+		{
+			std::lock_guard lock { queue.Mutex };
+			queue.Tasks.push_back({ std::move(task), &group });
+		}
+		m_QueuedCount.fetch_add(1, std::memory_order_release);
+
+		// Taking the sleep mutex orders this wake-up after any worker that is about to wait
+		{
+			std::lock_guard lock { m_SleepMutex };
+		}
+		m_WakeCondition.notify_one();
+	}
+
+	void ThreadPool::Wait(TaskGroup& group)
+	{
+		const auto queue = CurrentQueue();
+		while (!group.Done())
+		{
+			if (!TryRunTask(queue))
+				std::this_thread::yield();
+		}
+	}
+
+	void ThreadPool::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body)
+	{
+		if (count == 0)
+			return;
+
+		grainSize = std::max<size_t>(grainSize, 1);
+		if (m_Workers.empty() || count <= grainSize)
+		{
+			body(0, count);
+			return;
+		}
+
+		TaskGroup group {};
+		for (size_t begin = 0; begin < count; begin += grainSize)
+		{
+			const auto end = std::min(begin + grainSize, count);
+			Submit(group, [&body, begin, end] { body(begin, end); });
+		}
+		Wait(group);
+	}
+
+	bool ThreadPool::TryPop(size_t queue, QueuedTask& task)
+	{
+		auto& worker = *m_Queues[queue];
+		std::lock_guard lock { worker.Mutex };
+		if (worker.Tasks.empty())
+			return false;
+
+		task = std::move(worker.Tasks.back());
+		worker.Tasks.pop_back();
+		return true;
+	}
+
+	bool ThreadPool::TrySteal(size_t queue, QueuedTask& task)
+	{
+		auto& victim = *m_Queues[queue];
+		std::unique_lock lock { victim.Mutex, std::try_to_lock };
+		if (!lock.owns_lock() || victim.Tasks.empty())
+			return false;
+
+		task = std::move(victim.Tasks.front());
+		victim.Tasks.pop_front();
+		return true;
+	}
+
+	bool ThreadPool::TryRunTask(size_t preferredQueue)
+	{
+		if (m_QueuedCount.load(std::memory_order_acquire) == 0)
+			return false;
+
+		QueuedTask task {};
+		bool found = TryPop(preferredQueue, task);
+		for (size_t i = 1; !found && i < m_Queues.size(); i++)
+			found = TrySteal((preferredQueue + i) % m_Queues.size(), task);
+		if (!found)
+			return false;
+
+		m_QueuedCount.fetch_sub(1, std::memory_order_relaxed);
+		task.Function();
+		task.Group->m_Pending.fetch_sub(1, std::memory_order_acq_rel);
+		return true;
+	}
+
+	void ThreadPool::WorkerLoop(size_t index)
+	{
+		t_CurrentPool = this;
+		t_CurrentQueue = index;
+
+		while (true)
+		{
+			if (TryRunTask(index))
+				continue;
+
+			std::unique_lock lock { m_SleepMutex };
+			m_WakeCondition.wait(lock, [this]
+			{
+				return m_Stopping || m_QueuedCount.load(std::memory_order_acquire) > 0;
+			});
+			if (m_Stopping && m_QueuedCount.load(std::memory_order_acquire) == 0)
+				return;
+		}
+	}
+}
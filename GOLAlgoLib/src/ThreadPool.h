@@ -0,0 +1,87 @@
+#ifndef __ThreadPool_h__
+#define __ThreadPool_h__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gol
+{
+	// Fork-join pool where every worker owns a deque of tasks. Workers pop their own newest task and
+	// steal the oldest task of another worker when they run dry, and threads that wait on a group
+	// run pending tasks instead of blocking, so tasks may safely submit and wait on nested groups.
+	class ThreadPool
+	{
+	public:
+		using Task = std::function<void()>;
+
+		class TaskGroup
+		{
+		public:
+			TaskGroup() = default;
+			TaskGroup(const TaskGroup&) = delete;
+			TaskGroup& operator=(const TaskGroup&) = delete;
+
+			bool Done() const { return m_Pending.load(std::memory_order_acquire) == 0; }
+		private:
+			friend ThreadPool;
+			std::atomic<size_t> m_Pending = 0;
+		};
+	public:
+		// The calling thread counts as one of the threads, so a count of 1 spawns no workers
+		explicit ThreadPool(uint32_t threadCount = DefaultThreadCount());
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		uint32_t ThreadCount() const { return static_cast<uint32_t>(m_Workers.size()) + 1; }
+
+		void Submit(TaskGroup& group, Task task);
+
+		// Runs pending tasks on the calling thread until every task in the group has finished
+		void Wait(TaskGroup& group);
+
+		// Calls body(begin, end) over [0, count) in chunks of at most grainSize and waits for all of them
+		void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body);
+
+		static uint32_t DefaultThreadCount();
+	private:
+		struct QueuedTask
+		{
+			Task Function;
+			TaskGroup* Group;
+		};
+
+		struct WorkerQueue
+		{
+			std::mutex Mutex;
+			std::deque<QueuedTask> Tasks;
+		};
+
+		void WorkerLoop(size_t index);
+
+		bool TryRunTask(size_t preferredQueue);
+		bool TryPop(size_t queue, QueuedTask& task);
+		bool TrySteal(size_t queue, QueuedTask& task);
+
+		size_t CurrentQueue();
+	private:
+		std::vector<std::unique_ptr<WorkerQueue>> m_Queues;
+		std::vector<std::jthread> m_Workers;
+
+		std::mutex m_SleepMutex;
+		std::condition_variable m_WakeCondition;
+		std::atomic<size_t> m_QueuedCount = 0;
+		bool m_Stopping = false;
+	};
+}
+
+#endif
@@ -0,0 +1,336 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <unordered_dense.h>
+
+#include "Graphics2D.h"
+#include "LifeAlgorithm.h"
+#include "LifeHashSet.h"
+#include "LifeKernel.h"
+#include "LifeRule.h"
+#include "LifeTileMap.h"
+#include "ThreadPool.h"
+
+namespace gol
+{
+	bool LifeTile::Empty(const RowArray& rows)
+	{
+		return std::ranges::all_of(rows, [](uint64_t row) { return row == 0; });
+	}
+
+	int64_t LifeTile::Population(const RowArray& rows)
+	{
+		int64_t result = 0;
+		for (auto row : rows)
+			result += std::popcount(row);
+		return result;
+	}
+
+	uint16_t LifeTile::ChangeMaskOf(const RowArray& next, const RowArray& before)
+	{
+		constexpr auto last = Size - 1;
+
+		uint64_t columns = 0;
+		for (int32_t y = 0; y < Size; y++)
+			columns |= next[y] ^ before[y];
+		if (columns == 0)
+			return 0;
+
+		const auto north = next[0] ^ before[0];
+		const auto south = next[last] ^ before[last];
+
+		// Bit (dy + 1) * 3 + (dx + 1) marks the neighbor in direction (dx, dy)
+		uint16_t mask = 1 << 4;
+		mask |= (north & 1)         ? 1 << 0 : 0;
+		mask |= (north != 0)        ? 1 << 1 : 0;
+		mask |= (north >> last)     ? 1 << 2 : 0;
+		mask |= (columns & 1)       ? 1 << 3 : 0;
+		mask |= (columns >> last)   ? 1 << 5 : 0;
+		mask |= (south & 1)         ? 1 << 6 : 0;
+		mask |= (south != 0)        ? 1 << 7 : 0;
+		mask |= (south >> last)     ? 1 << 8 : 0;
+		return mask;
+	}
+
+	LifeTileMap::LifeTileMap(const LifeHashSet& cells)
+	{
+		for (const auto& cell : cells)
+		{
+			auto& tile = m_Tiles[TilePos(cell)];
+			tile.Buffers[m_Buffer][cell.Y & (LifeTile::Size - 1)] |= uint64_t { 1 } << (cell.X & (LifeTile::Size - 1));
+		}
+		ResetHistory();
+	}
+
+	bool LifeTileMap::empty() const
+	{
+		return std::ranges::all_of(m_Tiles, [this](const auto& entry) { return LifeTile::Empty(entry.second.Buffers[m_Buffer]); });
+	}
+
+	LifeTileMap::ConstIterator LifeTileMap::begin() const
+	{
+		return ConstIterator { m_Tiles.begin(), m_Tiles.end(), m_Buffer };
+	}
+
+	LifeTileMap::ConstIterator LifeTileMap::end() const
+	{
+		return ConstIterator { m_Tiles.end(), m_Tiles.end(), m_Buffer };
+	}
+
+	int64_t LifeTileMap::Population() const
+	{
+		int64_t result = 0;
+		for (const auto& [pos, tile] : m_Tiles)
+			result += LifeTile::Population(tile.Buffers[m_Buffer]);
+		return result;
+	}
+
+	const LifeTile* LifeTileMap::FindTile(Vec2 tilePos) const
+	{
+		auto itr = m_Tiles.find(tilePos);
+		return itr != m_Tiles.end() ? &itr->second : nullptr;
+	}
+
+	LifeTileMap::Neighborhood LifeTileMap::FindNeighborhood(Vec2 tilePos) const
+	{
+		Neighborhood result {};
+		for (int32_t dy = -1; dy <= 1; dy++)
+		{
+			for (int32_t dx = -1; dx <= 1; dx++)
+				result[(dy + 1) * 3 + dx + 1] = FindTile({ tilePos.X + dx, tilePos.Y + dy });
+		}
+		return result;
+	}
+
+	void LifeTileMap::ResetHistory()
+	{
+		m_ActiveTiles.clear();
+		m_ActiveTiles.reserve(m_Tiles.size());
+		for (auto& [pos, tile] : m_Tiles)
+		{
+			tile.ChangeMask = LifeTile::AllChanged;
+			m_ActiveTiles.push_back(pos);
+		}
+		m_HistoryValid = false;
+	}
+
+	void LifeTileMap::SetRule(const LifeRule& rule)
+	{
+		if (rule == m_Rule)
+			return;
+
+		// The other buffers were stepped under the old rule, so they no longer predict anything
+		m_Rule = rule;
+		ResetHistory();
+	}
+
+	LifeTile::RowArray LifeTileMap::AdvanceTile(const Neighborhood& neighborhood) const
+	{
+		constexpr auto size = LifeTile::Size;
+		constexpr auto last = size - 1;
+
+		const auto* northWest = neighborhood[0];
+		const auto* north     = neighborhood[1];
+		const auto* northEast = neighborhood[2];
+		const auto* west      = neighborhood[3];
+		const auto* center    = neighborhood[4];
+		const auto* east      = neighborhood[5];
+		const auto* southWest = neighborhood[6];
+		const auto* south     = neighborhood[7];
+		const auto* southEast = neighborhood[8];
+
+		const auto row = [this](const LifeTile* tile, int32_t y) { return tile ? tile->Buffers[m_Buffer][y] : uint64_t { 0 }; };
+
+		// Rows -1 and 64 come from the tiles above and below, so index i here is row i - 1
+		std::array<uint64_t, size + 2> middle {};
+		std::array<uint64_t, size + 2> westShifted {};
+		std::array<uint64_t, size + 2> eastShifted {};
+
+		const auto fill = [&](int32_t index, uint64_t centerRow, uint64_t westRow, uint64_t eastRow)
+		{
+			middle[index] = centerRow;
+			westShifted[index] = (centerRow << 1) | (westRow >> last);
+			eastShifted[index] = (centerRow >> 1) | (eastRow << last);
+		};
+
+		fill(0, row(north, last), row(northWest, last), row(northEast, last));
+		for (int32_t y = 0; y < size; y++)
+			fill(y + 1, row(center, y), row(west, y), row(east, y));
+		fill(size + 1, row(south, 0), row(southWest, 0), row(southEast, 0));
+
+		LifeTile::RowArray result {};
+		LifeKernel::StepRows(westShifted.data(), middle.data(), eastShifted.data(), result.data(), size, m_Rule);
+		return result;
+	}
+
+	void LifeTileMap::ClipToBounds(LifeTile::RowArray& rows, Vec2 tilePos, const Rect& bounds)
+	{
+		constexpr auto size = LifeTile::Size;
+		const auto corner = Vec2 { tilePos.X * size, tilePos.Y * size };
+
+		const auto minX = std::clamp(bounds.X - corner.X, 0, size);
+		const auto maxX = std::clamp(bounds.X + bounds.Width - corner.X, 0, size);
+		const auto minY = std::clamp(bounds.Y - corner.Y, 0, size);
+		const auto maxY = std::clamp(bounds.Y + bounds.Height - corner.Y, 0, size);
+		if (minX >= maxX || minY >= maxY)
+		{
+			rows.fill(0);
+			return;
+		}
+
+		const auto columnMask = (maxX - minX == size)
+			? ~uint64_t { 0 }
+			: ((uint64_t { 1 } << (maxX - minX)) - 1) << minX;
+		for (int32_t y = 0; y < size; y++)
+			rows[y] &= (y >= minY && y < maxY) ? columnMask : 0;
+	}
+
+	LifeTileMap::TileUpdate LifeTileMap::UpdateTile(Vec2 tilePos, const Rect& bounds) const
+	{
+		static const LifeTile::RowArray emptyRows {};
+
+		const auto neighborhood = FindNeighborhood(tilePos);
+		const auto* center = neighborhood[4];
+
+		TileUpdate update { .Pos = tilePos, .Rows = AdvanceTile(neighborhood), .ChangeMask = 0 };
+		if (bounds.Width > 0 && bounds.Height > 0)
+			ClipToBounds(update.Rows, tilePos, bounds);
+
+		// Until the map has been stepped once, the other buffer does not hold a real generation
+		const auto& beforePrevious = center ? center->Buffers[m_Buffer ^ 1] : emptyRows;
+		update.ChangeMask = m_HistoryValid ? LifeTile::ChangeMaskOf(update.Rows, beforePrevious) : LifeTile::AllChanged;
+		return update;
+	}
+
+	void LifeTileMap::ApplyUpdates(std::span<const TileUpdate> updates)
+	{
+		const auto next = m_Buffer ^ 1;
+
+		std::vector<Vec2> active {};
+		for (const auto& update : updates)
+		{
+			auto itr = m_Tiles.find(update.Pos);
+			if (itr == m_Tiles.end())
+			{
+				// Missing tiles were empty for the last two generations, so an empty update is no change
+				if (LifeTile::Empty(update.Rows))
+					continue;
+				itr = m_Tiles.emplace(update.Pos, LifeTile {}).first;
+			}
+
+			auto& tile = itr->second;
+			tile.Buffers[next] = update.Rows;
+			tile.ChangeMask = update.ChangeMask;
+
+			if (tile.ChangeMask != 0)
+				active.push_back(update.Pos);
+			else if (LifeTile::Empty(tile.Buffers[next]) && LifeTile::Empty(tile.Buffers[m_Buffer]))
+				m_Tiles.erase(itr);
+		}
+		m_ActiveTiles = std::move(active);
+		m_Buffer = next;
+	}
+
+	void LifeTileMap::Advance(const Rect& bounds, ThreadPool* pool)
+	{
+		if (bounds != m_Bounds)
+		{
+			m_Bounds = bounds;
+			ResetHistory();
+		}
+
+		// A tile that sees the same cells as two generations ago repeats its previous generation, which
+		// is already in its other buffer. Only tiles that can see a change since then are stepped.
+		ankerl::unordered_dense::set<Vec2> candidates {};
+		candidates.reserve(m_ActiveTiles.size() * 2);
+		for (const auto& pos : m_ActiveTiles)
+		{
+			const auto mask = FindTile(pos)->ChangeMask;
+			for (int32_t i = 0; i < 9; i++)
+			{
+				if (mask & (1 << i))
+					candidates.insert({ pos.X + i % 3 - 1, pos.Y + i / 3 - 1 });
+			}
+		}
+
+		// Updates only read the current buffers, so they can be computed in any order and
+		// applied afterwards in candidate order, keeping the result identical to a serial step
+		const auto& positions = candidates.values();
+		std::vector<TileUpdate> updates(positions.size());
+		const auto updateRange = [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+				updates[i] = UpdateTile(positions[i], bounds);
+		};
+
+		if (pool)
+			pool->ParallelFor(positions.size(), ParallelGrainSize, updateRange);
+		else
+			updateRange(0, positions.size());
+
+		ApplyUpdates(updates);
+		m_HistoryValid = true;
+	}
+
+	LifeTileMap::ConstIterator::ConstIterator(TileMap::const_iterator tile, TileMap::const_iterator end, int32_t buffer)
+		: m_Tile(tile), m_End(end), m_Buffer(buffer), m_Row(-1)
+	{
+		AdvanceToNext();
+	}
+
+	void LifeTileMap::ConstIterator::AdvanceToNext()
+	{
+		while (m_Tile != m_End)
+		{
+			if (m_RemainingBits != 0)
+			{
+				const auto column = std::countr_zero(m_RemainingBits);
+				m_RemainingBits &= m_RemainingBits - 1;
+				m_Current =
+				{
+					m_Tile->first.X * LifeTile::Size + column,
+					m_Tile->first.Y * LifeTile::Size + m_Row
+				};
+				return;
+			}
+
+			if (++m_Row < LifeTile::Size)
+			{
+				m_RemainingBits = m_Tile->second.Buffers[m_Buffer][m_Row];
+				continue;
+			}
+
+			++m_Tile;
+			m_Row = -1;
+		}
+	}
+
+	LifeTileMap::ConstIterator& LifeTileMap::ConstIterator::operator++()
+	{
+		AdvanceToNext();
+		return *this;
+	}
+
+	LifeTileMap::ConstIterator LifeTileMap::ConstIterator::operator++(int)
+	{
+		auto copy = *this;
+		AdvanceToNext();
+		return copy;
+	}
+
+	bool LifeTileMap::ConstIterator::operator==(const ConstIterator& other) const
+	{
+		if (m_Tile == m_End || other.m_Tile == other.m_End)
+			return (m_Tile == m_End) == (other.m_Tile == other.m_End);
+		return m_Tile == other.m_Tile && m_Row == other.m_Row && m_RemainingBits == other.m_RemainingBits;
+	}
+
+	LifeTileMap& TileLife(LifeTileMap& data, const Rect& bounds, ThreadPool* pool)
+	{
+		data.Advance(bounds, pool);
+		return data;
+	}
+}
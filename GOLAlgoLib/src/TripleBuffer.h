@@ -0,0 +1,54 @@
+#ifndef __TripleBuffer_h__
+#define __TripleBuffer_h__
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace gol
+{
+	// Hands values from one producer to one consumer without locks or copies. The producer fills
+	// the back slot and publishes it by swapping it with the middle slot, and the consumer picks up
+	// the middle slot by swapping it with the front one. A value published before the consumer got
+	// to the previous one replaces it, so a fast producer never queues up stale values.
+	//
+	// Slots are reused rather than reset, so a value's buffers keep their capacity from one use to
+	// the next. Each role may move between threads, as long as the move synchronizes.
+	template <typename T>
+	class TripleBuffer
+	{
+	public:
+		// The slot the producer fills next. It holds whatever was published two or more values ago.
+		T& Back() { return m_Slots[m_Back]; }
+
+		void Publish()
+		{
+			m_Back = m_Middle.exchange(m_Back | FreshBit, std::memory_order_acq_rel) & IndexMask;
+		}
+
+		// Picks up the newest value if one was published since the last call. The value stays valid
+		// until the next call.
+		const T& Acquire()
+		{
+			if (m_Middle.load(std::memory_order_relaxed) & FreshBit)
+				m_Front = m_Middle.exchange(m_Front, std::memory_order_acq_rel) & IndexMask;
+			return m_Slots[m_Front];
+		}
+
+		// True when a value has been published that Acquire has not picked up yet
+		bool HasFresh() const { return m_Middle.load(std::memory_order_relaxed) & FreshBit; }
+
+		// The value picked up by the last call to Acquire
+		const T& Front() const { return m_Slots[m_Front]; }
+	private:
+		static constexpr uint8_t IndexMask = 0b011;
+		static constexpr uint8_t FreshBit = 0b100;
+	private:
+		std::array<T, 3> m_Slots {};
+		uint8_t m_Back = 0;
+		std::atomic<uint8_t> m_Middle = 1;
+		uint8_t m_Front = 2;
+	};
+}
+
+#endif
@@ -26,6 +26,8 @@ namespace gol
 		glm::vec2 WorldToScreenPos(Vec2F pos, const Rect& viewBounds, Size2F worldSize) const;
 
 		glm::mat4 OrthographicProjection(Size2 viewSize) const;
+
+		bool operator==(const GraphicsCamera&) const = default;
 	};
 }
 
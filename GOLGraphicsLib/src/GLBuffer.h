@@ -87,8 +87,9 @@ gol::GLWrapper<GeneratorType, DeleterType, Generator, Deleter>::GLWrapper(GLWrap
 template <gol::GLGenerator GeneratorType, gol::GLDeleter DeleterType, GeneratorType Generator, DeleterType Deleter>
 auto& gol::GLWrapper<GeneratorType, DeleterType, Generator, Deleter>::operator=(GLWrapper<GeneratorType, DeleterType, Generator, Deleter>&& other) noexcept
 {
+	// Swapped, so the object that was here is deleted along with other
 	if (this != &other)
-		m_ID = std::exchange(other.m_ID, 0);
+		std::swap(m_ID, other.m_ID);
 	return *this;
 }
 
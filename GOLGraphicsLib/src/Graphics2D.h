@@ -49,6 +49,8 @@ namespace gol
 
 		constexpr GenericSize() : Width(0), Height(0) { }
 		constexpr GenericSize(T width, T height) : Width(width), Height(height) { }
+
+		constexpr bool operator==(const GenericSize<T>&) const = default;
 	};
 
 	template <std::totally_ordered T>
@@ -72,6 +74,8 @@ namespace gol
 		constexpr GenericRect(T x, T y, T width, T height) : X(x), Y(y), Width(width), Height(height) { }
 		constexpr GenericRect(GenericVec<T> pos, GenericSize<T> size) : X(pos.X), Y(pos.Y), Width(size.Width), Height(size.Height) {}
 
+		constexpr bool operator==(const GenericRect<T>&) const = default;
+
 		constexpr bool InBounds(std::totally_ordered auto x, std::totally_ordered auto y) const
 			{ return x >= X && x < X + Width && y >= Y && y < Y + Height; }
 		
@@ -127,6 +131,7 @@ namespace gol
 	};
 
 	using Vec2 = GenericVec<int32_t>;
+	using Vec2L = GenericVec<int64_t>;
 
 	using Size2 = GenericSize<int32_t>;
 
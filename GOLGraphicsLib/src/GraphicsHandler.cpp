@@ -30,6 +30,7 @@ gol::GraphicsHandler::GraphicsHandler(
     : m_BgColor(bgColor)
     , m_GridShader(shaderDirectory / "grid.shader")
 	, m_SelectionShader(shaderDirectory / "selection.shader")
+    , m_TextureSize(windowWidth, windowHeight)
 {
     InitGridBuffer();
 
@@ -79,11 +80,9 @@ void gol::GraphicsHandler::InitGridBuffer()
     GL_DEBUG(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_CellIndexBuffer.ID()));
     GL_DEBUG(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(quadIndices), quadIndices, GL_STATIC_DRAW));
 
-    GL_DEBUG(glBindBuffer(GL_ARRAY_BUFFER, m_InstanceBuffer.ID()));
-    GL_DEBUG(glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_DYNAMIC_DRAW));
-    GL_DEBUG(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 2, nullptr));
-    GL_DEBUG(glEnableVertexAttribArray(1));
-    GL_DEBUG(glVertexAttribDivisor(1, 1));
+    // The instance buffer points the attribute at its latest write each time it is drawn
+    GL_DEBUG(glEnableVertexAttribArray(InstanceAttribute));
+    GL_DEBUG(glVertexAttribDivisor(InstanceAttribute, 1));
 
     GL_DEBUG(glBindVertexArray(0));
 }
@@ -91,17 +90,21 @@ void gol::GraphicsHandler::InitGridBuffer()
 
 void gol::GraphicsHandler::RescaleFrameBuffer(const Rect& windowBounds, const Rect& viewportBounds)
 {
-    GL_DEBUG(glBindTexture(GL_TEXTURE_2D, m_Texture.ID()));
-    GL_DEBUG(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, windowBounds.Width, windowBounds.Height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL));
-    GL_DEBUG(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-    GL_DEBUG(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-
     FrameBufferBinder binder { m_FrameBuffer };
     
     glViewport(
         viewportBounds.X - windowBounds.X, viewportBounds.Y - windowBounds.Y, 
         viewportBounds.Width, viewportBounds.Height
     );
+    if (windowBounds.Size() == m_TextureSize)
+        return;
+    m_TextureSize = windowBounds.Size();
+
+    GL_DEBUG(glBindTexture(GL_TEXTURE_2D, m_Texture.ID()));
+    GL_DEBUG(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, windowBounds.Width, windowBounds.Height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL));
+    GL_DEBUG(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+    GL_DEBUG(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+
     GL_DEBUG(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_Texture.ID(), 0));
     GL_DEBUG(glBindRenderbuffer(GL_RENDERBUFFER, m_renderBuffer.ID()));
     GL_DEBUG(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, windowBounds.Width, windowBounds.Height));
@@ -11,6 +11,7 @@
 #include "Camera.h"
 #include "GLBuffer.h"
 #include "Graphics2D.h"
+#include "InstanceBuffer.h"
 #include "ShaderManager.h"
 #include "Logging.h"
 
@@ -55,9 +56,11 @@ namespace gol
 		GraphicsHandler& operator=(GraphicsHandler&& other) noexcept = default;
 		~GraphicsHandler() = default;
 
+		// Sets the viewport for the draws that follow. The texture is only reallocated when the window
+		// size changes, so a handler that is not redrawn keeps showing what it drew last.
 		void RescaleFrameBuffer(const Rect& windowBounds, const Rect& viewportBounds);
 
-		void DrawGrid(Vec2 offset, const std::ranges::input_range auto& grid, const GraphicsHandlerArgs& args);
+		void DrawGrid(Vec2 offset, std::ranges::forward_range auto&& grid, const GraphicsHandlerArgs& args);
 		void DrawSelection(const Rect& region, const GraphicsHandlerArgs& info);
 		void ClearBackground(const GraphicsHandlerArgs& args);
 
@@ -65,9 +68,9 @@ namespace gol
 
 		uint32_t TextureID() const { return m_Texture.ID(); }
 	private:
-		void InitGridBuffer();
+		static constexpr uint32_t InstanceAttribute = 1;
 
-		std::vector<float> GenerateGLBuffer(Vec2 offset, const std::ranges::input_range auto& grid, const GraphicsHandlerArgs& args) const;
+		void InitGridBuffer();
 
 		RectDouble GridToScreenBounds(const Rect& region, const GraphicsHandlerArgs& args) const;
 	private:
@@ -87,7 +90,7 @@ namespace gol
 		ShaderManager m_SelectionShader;
 		
 		GLVertexArray m_GridVAO;
-		GLBuffer m_InstanceBuffer;
+		InstanceBuffer m_InstanceBuffer { InstanceAttribute };
 		GLBuffer m_CellBuffer;
 		GLIndexBuffer m_CellIndexBuffer;
 
@@ -99,23 +102,11 @@ namespace gol
 		GLFrameBuffer m_FrameBuffer;
 		GLTexture m_Texture;
 		GLRenderBuffer m_renderBuffer;
+		Size2 m_TextureSize;
 	};
 }
 
-std::vector<float> gol::GraphicsHandler::GenerateGLBuffer(Vec2 offset, const std::ranges::input_range auto& grid, const GraphicsHandlerArgs& args) const
-{
-	std::vector<float> result {};
-	result.reserve(grid.size() * 2);
-	for (const Vec2& vec : grid)
-	{
-		result.push_back(vec.X + offset.X);
-		result.push_back(vec.Y + offset.Y);
-	}
-
-	return result;
-}
-
-void gol::GraphicsHandler::DrawGrid(Vec2 offset, const std::ranges::input_range auto& grid, const GraphicsHandlerArgs& args)
+void gol::GraphicsHandler::DrawGrid(Vec2 offset, std::ranges::forward_range auto&& grid, const GraphicsHandlerArgs& args)
 {
 	FrameBufferBinder binder { m_FrameBuffer };
 
@@ -135,14 +126,12 @@ void gol::GraphicsHandler::DrawGrid(Vec2 offset, const std::ranges::input_range
 	m_GridShader.AttachUniformMatrix4("u_MVP", matrix);
 	m_GridShader.AttachUniformVec4("u_Color", { 1.f, 1.f, 1.f, 1.f });
 
-	auto positions = GenerateGLBuffer(offset, grid, args);
-
-	GL_DEBUG(glBindBuffer(GL_ARRAY_BUFFER, m_InstanceBuffer.ID()));
-	
-	GL_DEBUG(glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(float), nullptr, GL_DYNAMIC_DRAW));
-	GL_DEBUG(glBufferSubData(GL_ARRAY_BUFFER, 0, positions.size() * sizeof(float), positions.data()));
-
-	GL_DEBUG(glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr, static_cast<GLsizei>(positions.size() / 2)));
+	const auto instances = m_InstanceBuffer.Write(offset, grid);
+	if (instances > 0)
+	{
+		GL_DEBUG(glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr, instances));
+		m_InstanceBuffer.Fence();
+	}
 
 	GL_DEBUG(glBindVertexArray(0));
 }
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <GL/glew.h>
+#include <utility>
+
+#include "GLBuffer.h"
+#include "InstanceBuffer.h"
+#include "Logging.h"
+
+namespace
+{
+    constexpr GLbitfield PersistentFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+}
+
+gol::InstanceBuffer::InstanceBuffer(uint32_t attribute)
+    : m_Attribute(attribute)
+    , m_Persistent(GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)
+{
+    Allocate(InitialCapacity);
+}
+
+gol::InstanceBuffer::~InstanceBuffer()
+{
+    // Deleting the buffer unmaps it
+    DeleteFences();
+}
+
+gol::InstanceBuffer::InstanceBuffer(InstanceBuffer&& other) noexcept
+    : m_Buffer(std::move(other.m_Buffer))
+    , m_Attribute(other.m_Attribute)
+    , m_Persistent(other.m_Persistent)
+    , m_Capacity(std::exchange(other.m_Capacity, 0))
+    , m_Mapped(std::exchange(other.m_Mapped, nullptr))
+    , m_Region(other.m_Region)
+    , m_Fences(std::exchange(other.m_Fences, {}))
+{ }
+
+gol::InstanceBuffer& gol::InstanceBuffer::operator=(InstanceBuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        m_Buffer = std::move(other.m_Buffer);
+        m_Attribute = other.m_Attribute;
+        m_Persistent = other.m_Persistent;
+        std::swap(m_Capacity, other.m_Capacity);
+        std::swap(m_Mapped, other.m_Mapped);
+        m_Region = other.m_Region;
+        std::swap(m_Fences, other.m_Fences);
+    }
+    return *this;
+}
+
+void gol::InstanceBuffer::Fence()
+{
+    if (!m_Mapped)
+        return;
+
+    // A later fence covers everything the earlier one did
+    auto& fence = m_Fences[m_Region];
+    if (fence)
+    {
+        GL_DEBUG(glDeleteSync(fence));
+    }
+    GL_DEBUG(fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+}
+
+float* gol::InstanceBuffer::Map(size_t count)
+{
+    if (count > m_Capacity)
+        Allocate(std::max(count, m_Capacity * 2));
+
+    GL_DEBUG(glBindBuffer(GL_ARRAY_BUFFER, m_Buffer.ID()));
+    if (m_Mapped)
+    {
+        m_Region = (m_Region + 1) % RegionCount;
+        WaitForRegion(m_Region);
+        return m_Mapped + m_Region * m_Capacity * FloatsPerPosition;
+    }
+
+    // Orphaning at the same size each time lets the driver recycle the storage it hands out
+    const auto bytes = static_cast<GLsizeiptr>(m_Capacity * FloatsPerPosition * sizeof(float));
+    GL_DEBUG(glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW));
+    GL_DEBUG(auto* data = glMapBufferRange(
+        GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(count * FloatsPerPosition * sizeof(float)),
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT
+    ));
+    return static_cast<float*>(data);
+}
+
+void gol::InstanceBuffer::Unmap()
+{
+    const auto offset = m_Mapped ? m_Region * m_Capacity * FloatsPerPosition * sizeof(float) : 0;
+    if (!m_Mapped)
+    {
+        GL_DEBUG(glUnmapBuffer(GL_ARRAY_BUFFER));
+    }
+
+    GL_DEBUG(glVertexAttribPointer(
+        m_Attribute, FloatsPerPosition, GL_FLOAT, GL_FALSE,
+        FloatsPerPosition * sizeof(float), reinterpret_cast<const void*>(offset)
+    ));
+}
+
+void gol::InstanceBuffer::Allocate(size_t capacity)
+{
+    m_Capacity = capacity;
+    if (!m_Persistent)
+        return;
+
+    // Storage from glBufferStorage cannot be resized, so growing takes a new buffer. Draws still
+    // reading the old one keep it alive until they finish.
+    DeleteFences();
+    m_Buffer = GLBuffer {};
+
+    const auto bytes = static_cast<GLsizeiptr>(RegionCount * capacity * FloatsPerPosition * sizeof(float));
+    GL_DEBUG(glBindBuffer(GL_ARRAY_BUFFER, m_Buffer.ID()));
+    GL_DEBUG(glBufferStorage(GL_ARRAY_BUFFER, bytes, nullptr, PersistentFlags));
+    GL_DEBUG(m_Mapped = static_cast<float*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, PersistentFlags)));
+
+    // Immutable storage cannot be orphaned, so falling back takes a buffer without it
+    if (!m_Mapped)
+    {
+        m_Persistent = false;
+        m_Buffer = GLBuffer {};
+    }
+}
+
+void gol::InstanceBuffer::WaitForRegion(size_t region)
+{
+    auto& fence = m_Fences[region];
+    if (!fence)
+        return;
+
+    // Flushing makes sure the fence is submitted, so the wait cannot stall forever
+    GLenum status = GL_TIMEOUT_EXPIRED;
+    while (status == GL_TIMEOUT_EXPIRED)
+    {
+        GL_DEBUG(status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000));
+    }
+
+    GL_DEBUG(glDeleteSync(fence));
+    fence = nullptr;
+}
+
+void gol::InstanceBuffer::DeleteFences()
+{
+    for (auto& fence : m_Fences)
+    {
+        if (fence)
+        {
+            GL_DEBUG(glDeleteSync(fence));
+        }
+        fence = nullptr;
+    }
+}
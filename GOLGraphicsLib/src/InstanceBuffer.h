@@ -0,0 +1,91 @@
+#ifndef __InstanceBuffer_h__
+#define __InstanceBuffer_h__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <GL/glew.h>
+#include <ranges>
+
+#include "GLBuffer.h"
+#include "Graphics2D.h"
+
+namespace gol
+{
+	// Per-instance cell positions, written straight into memory the GPU reads from, so drawing a grid
+	// allocates nothing once the buffer is large enough.
+	//
+	// With buffer storage the buffer stays mapped and is split into regions that are written in turn,
+	// each guarded by a fence so a region is only overwritten once the draws reading it are done.
+	// Without it, the buffer is orphaned before each write so the driver hands out fresh memory
+	// rather than waiting on the last draw.
+	class InstanceBuffer
+	{
+	public:
+		// Enough for the main grid and a pasted selection to each be drawn on consecutive frames
+		static constexpr size_t RegionCount = 3;
+		static constexpr size_t InitialCapacity = 1024;
+	public:
+		// The attribute is pointed at each write, in whichever vertex array is bound at the time
+		explicit InstanceBuffer(uint32_t attribute);
+		~InstanceBuffer();
+
+		InstanceBuffer(const InstanceBuffer&) = delete;
+		InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+		InstanceBuffer(InstanceBuffer&& other) noexcept;
+		InstanceBuffer& operator=(InstanceBuffer&& other) noexcept;
+
+		// Writes every position moved by offset, and returns how many instances to draw. Views such as
+		// filter cannot be iterated through const, so the range is taken as it is passed.
+		GLsizei Write(Vec2 offset, std::ranges::forward_range auto&& positions);
+
+		// Call after the draws that read the last write, so the region is not overwritten under them
+		void Fence();
+
+		// Positions each region holds. It at least doubles whenever a write does not fit.
+		size_t Capacity() const { return m_Capacity; }
+	private:
+		static constexpr size_t FloatsPerPosition = 2;
+
+		// Makes room for count positions and returns where they go
+		float* Map(size_t count);
+
+		// Finishes the write started by Map, and points the attribute at it
+		void Unmap();
+
+		void Allocate(size_t capacity);
+		void WaitForRegion(size_t region);
+		void DeleteFences();
+	private:
+		GLBuffer m_Buffer;
+		uint32_t m_Attribute;
+
+		bool m_Persistent;
+		size_t m_Capacity = 0;
+
+		// Only used with buffer storage, where the whole buffer stays mapped
+		float* m_Mapped = nullptr;
+		size_t m_Region = 0;
+		std::array<GLsync, RegionCount> m_Fences {};
+	};
+}
+
+GLsizei gol::InstanceBuffer::Write(Vec2 offset, std::ranges::forward_range auto&& positions)
+{
+	const auto count = static_cast<size_t>(std::ranges::distance(positions));
+	if (count == 0)
+		return 0;
+
+	auto* data = Map(count);
+	for (const Vec2& pos : positions)
+	{
+		*data++ = static_cast<float>(pos.X + offset.X);
+		*data++ = static_cast<float>(pos.Y + offset.Y);
+	}
+	Unmap();
+
+	return static_cast<GLsizei>(count);
+}
+
+#endif
@@ -17,6 +17,7 @@ namespace gol
 		bool UndosAvailable = false;
 		bool RedosAvailable = false;
 		bool HasUnsavedChanges = false;
+		bool GridBounded = false;
 	};
 }
 
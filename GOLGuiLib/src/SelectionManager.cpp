@@ -248,12 +248,15 @@ std::optional<gol::VersionChange> gol::SelectionManager::Nudge(Vec2 translation)
     };
 }
 
-std::expected<gol::VersionChange, std::string> gol::SelectionManager::Load(const std::filesystem::path& filePath)
+std::expected<gol::VersionChange, std::string> gol::SelectionManager::Load(GameGrid& grid, const std::filesystem::path& filePath)
 {
 	auto result = RLEEncoder::ReadRegion(filePath);
     if (!result)
         return std::unexpected { std::move(result.error()) };
 
+    // A pattern only behaves as saved under the rule it was saved with
+    grid.SetRule(result->Grid.Rule());
+
     m_Selected = std::move(result->Grid);
 	m_AnchorSelection = result->Offset;
 	m_SentinelSelection = result->Offset + Vec2 { m_Selected->Width() - 1, m_Selected->Height() - 1 };
@@ -276,7 +279,11 @@ bool gol::SelectionManager::Save(const GameGrid& grid, const std::filesystem::pa
         return RLEEncoder::WriteRegion(grid, boundingBox, filePath, boundingBox.Pos());
 
     }
-    return RLEEncoder::WriteRegion(*m_Selected, Rect { { 0, 0 }, m_Selected->Size() }, filePath);
+
+    // Selections can come from the clipboard or undo history, so the grid's rule is the one in effect
+    auto selected = GameGrid { *m_Selected, m_Selected->Size() };
+    selected.SetRule(grid.Rule());
+    return RLEEncoder::WriteRegion(selected, Rect { { 0, 0 }, selected.Size() }, filePath);
 }
 
 std::optional<gol::VersionChange> gol::SelectionManager::HandleAction(SelectionAction action, GameGrid& grid, int32_t nudgeSize)
@@ -320,7 +327,10 @@ void gol::SelectionManager::HandleVersionChange(EditorAction undoRedo, GameGrid&
             if (undoRedo == EditorAction::Undo)
                 grid = change.GridResize->first;
             else
+            {
                 grid = GameGrid(grid, change.GridResize->second);
+                grid.SetAlgorithm(GameGrid::PreferredAlgorithm(grid.Size()));
+            }
             return;
         }
     }
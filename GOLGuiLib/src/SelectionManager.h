@@ -44,7 +44,8 @@ namespace gol
 
 		std::optional<VersionChange> Nudge(Vec2 translation);
 
-		std::expected<VersionChange, std::string> Load(const std::filesystem::path& filePath);
+		// Also switches the grid to the rule stored in the file
+		std::expected<VersionChange, std::string> Load(GameGrid& grid, const std::filesystem::path& filePath);
 		
 		bool Save(const GameGrid& grid, const std::filesystem::path& filePath) const;
 		
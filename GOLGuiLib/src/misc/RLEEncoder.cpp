@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstdint>
 #include <expected>
 #include <filesystem>
@@ -5,10 +6,12 @@
 #include <iterator>
 #include <limits>
 #include <string>
+#include <string_view>
 #include <variant>
 
 #include "GameGrid.h"
 #include "Graphics2D.h"
+#include "LifeRule.h"
 #include "RLEEncoder.h"
 
 template<class... Ts> struct Overloaded : Ts... { using Ts::operator()...; };
@@ -61,7 +64,7 @@ bool gol::RLEEncoder::WriteRegion(const GameGrid& grid, const Rect& region,
 		return false;
 
 	auto encodedData = EncodeRegion(grid, region, offset);
-	out << encodedData;
+	out << RuleHeader << grid.Rule().ToString() << '\n' << encodedData;
 
 	return true;
 }
@@ -74,9 +77,23 @@ std::expected<gol::RLEEncoder::DecodeResult, std::string> gol::RLEEncoder::ReadR
 
 	auto data = std::string { std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
 
-	auto decodeResult = RLEEncoder::DecodeRegion(data.c_str(), std::numeric_limits<uint32_t>::max());
+	// Files written before rules were stored have no header and use Conway's rule
+	auto rule = LifeRules::Conway;
+	auto body = std::string_view { data };
+	if (body.starts_with(RuleHeader))
+	{
+		const auto lineEnd = std::min(body.find('\n'), body.size());
+		const auto parsed = LifeRule::Parse(body.substr(RuleHeader.size(), lineEnd - RuleHeader.size()));
+		if (!parsed)
+			return std::unexpected { parsed.error() };
+		rule = *parsed;
+		body.remove_prefix(std::min(lineEnd + 1, body.size()));
+	}
+
+	auto decodeResult = RLEEncoder::DecodeRegion(std::string { body }.c_str(), std::numeric_limits<uint32_t>::max());
 	if (!decodeResult)
 		return std::unexpected { "File contains too many cells." };
+	decodeResult->Grid.SetRule(rule);
 	return *decodeResult;
 }
 
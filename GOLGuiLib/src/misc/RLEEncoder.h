@@ -9,6 +9,7 @@
 #include <limits>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -216,6 +217,10 @@ namespace gol::RLEEncoder
 
 	std::expected<DecodeResult, uint32_t> DecodeRegion(const char* data, uint32_t warnThreshold);
 
+	// Files start with a line naming the grid's rule, such as "#B36/S23". Encoded cells never start
+	// with '#', so files without the line can still be read.
+	inline constexpr std::string_view RuleHeader = "#";
+
 	bool WriteRegion(const GameGrid& grid, const Rect& region, 
 		const std::filesystem::path& filePath, Vec2 offset = { 0, 0 });
 
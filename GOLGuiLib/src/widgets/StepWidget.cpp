@@ -18,13 +18,14 @@ gol::SimulationControlResult gol::StepWidget::UpdateImpl(const EditorResult& sta
 
     ImGui::PushStyleVarY(ImGuiStyleVar_FramePadding, 10.f);
     ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x / 3.f * 2.f + 5);
-    ImGui::InputInt("##label", &m_StepCount, 1, BigStep);
+    ImGui::InputScalar("##label", ImGuiDataType_U64, &m_StepCount, &SmallStep, &BigStep);
     ImGui::PopStyleVar();
 
     if (m_StepCount < 1)
         m_StepCount = 1;
-    if (m_StepCount >= StepWarning)
-        ImGui::SetItemTooltip("Stepping with large values may cause lag!");
+    // Unbounded grids jump ahead with HashLife, but bounded ones are clipped every generation
+    if (m_StepCount >= StepWarning && state.GridBounded)
+        ImGui::SetItemTooltip("Stepping bounded grids with large values may cause lag!");
 
     ImGui::PushStyleVarY(ImGuiStyleVar_ItemSpacing, 30.f);
     auto result = m_Button.Update(state);
@@ -30,8 +30,9 @@ namespace gol
 	class StepWidget : public Widget
 	{
     public:
-        static constexpr int32_t BigStep = 10;
-        static constexpr int32_t StepWarning = 100;
+        static constexpr uint64_t SmallStep = 1;
+        static constexpr uint64_t BigStep = 10;
+        static constexpr uint64_t StepWarning = 100;
 	public:
         StepWidget(std::span<const ImGuiKeyChord> shortcuts = {})
             : m_Button(shortcuts)
@@ -41,7 +42,7 @@ namespace gol
     private:
 		SimulationControlResult UpdateImpl(const EditorResult& state);
 	private:
-        int32_t m_StepCount = 1;
+        uint64_t m_StepCount = 1;
 
         StepButton m_Button;
 	};
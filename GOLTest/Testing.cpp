@@ -2,8 +2,28 @@
 #include <algorithm>
 #include <ranges>
 #include <random>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <thread>
+#include <unordered_dense.h>
+#include <vector>
 
+#include "ConcurrentInternTable.h"
+#include "GameGrid.h"
 #include "HashQuadtree.h"
+#include "LifeAlgorithm.h"
+#include "LifeKernel.h"
+#include "LifeRule.h"
+#include "RLEEncoder.h"
+#include "SimulationClock.h"
+#include "SimulationWorker.h"
+#include "SlabArena.h"
+#include "ThreadPool.h"
+#include "TripleBuffer.h"
 
 using namespace gol;
 
@@ -113,6 +133,20 @@ TEST(HashQuadtreeTest, Checkerboard) {
     VerifyContent(tree, cells);
 }
 
+TEST(HashQuadtreeTest, DenseBlocksShareLeaves) {
+    LifeHashSet block;
+    for (int y = -32; y < 32; ++y) {
+        for (int x = -32; x < 32; ++x) {
+            block.insert({x, y});
+        }
+    }
+    HashQuadtree tree(block);
+    VerifyContent(tree, block);
+
+    // One full 8x8 leaf and one node per level above it, plus the empty leaf
+    EXPECT_EQ(tree.NodeMemoryStats().Objects, 5u);
+}
+
 TEST(HashQuadtreeTest, RangesCompliance) {
     static_assert(std::ranges::range<HashQuadtree>);
     static_assert(std::ranges::input_range<HashQuadtree>);
@@ -125,4 +159,1187 @@ TEST(HashQuadtreeTest, RangesCompliance) {
         return v.X > 1; // Should find {2,2} and {3,3}
     });
     EXPECT_EQ(count, 2);
-}
\ No newline at end of file
+}
+
+// Helper to fill a grid with a reproducible random soup
+static LifeHashSet RandomSoup(int32_t width, int32_t height, uint32_t seed) {
+    LifeHashSet cells;
+    std::mt19937 gen(seed);
+    std::bernoulli_distribution alive(0.35);
+    for (int32_t x = 0; x < width; ++x) {
+        for (int32_t y = 0; y < height; ++y) {
+            if (alive(gen)) cells.insert({x, y});
+        }
+    }
+    return cells;
+}
+
+static GameGrid MakeGrid(const LifeHashSet& cells, Size2 size, LifeAlgorithm algorithm) {
+    GameGrid grid { size, algorithm };
+    for (const auto& pos : cells) {
+        grid.Set(pos.X, pos.Y, true);
+    }
+    return grid;
+}
+
+TEST(HashLifeTest, BlinkerOscillates) {
+    LifeHashSet horizontal = { {0, 1}, {1, 1}, {2, 1} };
+    LifeHashSet vertical = { {1, 0}, {1, 1}, {1, 2} };
+    HashQuadtree tree { horizontal };
+
+    tree.Advance({});
+    VerifyContent(tree, vertical);
+
+    tree.Advance({});
+    VerifyContent(tree, horizontal);
+}
+
+TEST(HashLifeTest, GliderTranslates) {
+    LifeHashSet glider = { {1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2} };
+    HashQuadtree tree { glider };
+
+    for (int i = 0; i < 40; ++i) {
+        tree.Advance({});
+    }
+
+    LifeHashSet expected;
+    for (const auto& pos : glider) {
+        expected.insert({pos.X + 10, pos.Y + 10});
+    }
+    VerifyContent(tree, expected);
+}
+
+TEST(HashLifeTest, MatchesSparseLifeUnbounded) {
+    const auto soup = RandomSoup(48, 48, 777);
+    auto sparse = MakeGrid(soup, {0, 0}, LifeAlgorithm::SparseLife);
+    auto hash = MakeGrid(soup, {0, 0}, LifeAlgorithm::HashLife);
+
+    for (int i = 0; i < 200; ++i) {
+        sparse.Update();
+        hash.Update();
+        ASSERT_EQ(sparse.Data(), hash.Data()) << "Diverged at generation " << sparse.Generation();
+    }
+    EXPECT_EQ(sparse.Population(), hash.Population());
+    EXPECT_EQ(sparse.Generation(), hash.Generation());
+}
+
+TEST(HashLifeTest, MatchesSparseLifeBounded) {
+    const auto soup = RandomSoup(40, 30, 4242);
+    auto sparse = MakeGrid(soup, {40, 30}, LifeAlgorithm::SparseLife);
+    auto hash = MakeGrid(soup, {40, 30}, LifeAlgorithm::HashLife);
+
+    for (int i = 0; i < 150; ++i) {
+        sparse.Update();
+        hash.Update();
+        ASSERT_EQ(sparse.Data(), hash.Data()) << "Diverged at generation " << sparse.Generation();
+    }
+}
+
+TEST(HashLifeTest, EditsBetweenGenerations) {
+    const auto soup = RandomSoup(20, 20, 99);
+    auto sparse = MakeGrid(soup, {0, 0}, LifeAlgorithm::SparseLife);
+    auto hash = MakeGrid(soup, {0, 0}, LifeAlgorithm::HashLife);
+
+    for (int i = 0; i < 30; ++i) {
+        sparse.Update();
+        hash.Update();
+        sparse.Toggle(i, 5);
+        hash.Toggle(i, 5);
+    }
+    EXPECT_EQ(sparse.Data(), hash.Data());
+
+    auto copy = hash;
+    copy.Update();
+    sparse.Update();
+    EXPECT_EQ(sparse.Data(), copy.Data());
+}
+
+TEST(HashLifeTest, AdvanceByMatchesRepeatedUpdates) {
+    const auto soup = RandomSoup(32, 32, 2024);
+    for (uint64_t generations : { 1ULL, 2ULL, 7ULL, 64ULL, 333ULL }) {
+        auto stepped = MakeGrid(soup, {0, 0}, LifeAlgorithm::SparseLife);
+        auto jumped = MakeGrid(soup, {0, 0}, LifeAlgorithm::SparseLife);
+
+        for (uint64_t i = 0; i < generations; ++i) {
+            stepped.Update();
+        }
+        jumped.AdvanceBy(generations);
+
+        ASSERT_EQ(stepped.Data(), jumped.Data()) << "Mismatch after " << generations << " generations";
+        EXPECT_EQ(stepped.Generation(), jumped.Generation());
+        EXPECT_EQ(stepped.Population(), jumped.Population());
+    }
+}
+
+TEST(HashLifeTest, AdvanceByLargeJump) {
+    LifeHashSet glider = { {1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2} };
+    auto grid = MakeGrid(glider, {0, 0}, LifeAlgorithm::HashLife);
+
+    constexpr uint64_t generations = 1ULL << 24;
+    grid.AdvanceBy(generations);
+
+    LifeHashSet expected;
+    for (const auto& pos : glider) {
+        expected.insert({pos.X + static_cast<int32_t>(generations / 4), pos.Y + static_cast<int32_t>(generations / 4)});
+    }
+    EXPECT_EQ(grid.Data(), expected);
+    EXPECT_EQ(grid.Generation(), static_cast<int64_t>(generations));
+}
+
+TEST(HashLifeTest, AdvanceByBounded) {
+    const auto soup = RandomSoup(25, 25, 31337);
+    auto stepped = MakeGrid(soup, {25, 25}, LifeAlgorithm::HashLife);
+    auto jumped = MakeGrid(soup, {25, 25}, LifeAlgorithm::HashLife);
+
+    for (int i = 0; i < 50; ++i) {
+        stepped.Update();
+    }
+    jumped.AdvanceBy(50);
+    EXPECT_EQ(stepped.Data(), jumped.Data());
+}
+
+TEST(TileLifeTest, RoundTripsCells) {
+    LifeHashSet cells = { {0, 0}, {63, 63}, {64, 0}, {-1, -1}, {-64, 5}, {1000, -1000} };
+    LifeTileMap tiles { cells };
+
+    LifeHashSet actual { tiles.begin(), tiles.end() };
+    EXPECT_EQ(actual, cells);
+    EXPECT_EQ(tiles.Population(), static_cast<int64_t>(cells.size()));
+}
+
+TEST(TileLifeTest, MatchesSparseLifeUnbounded) {
+    // Offset the soup so it straddles tile boundaries in every direction
+    LifeHashSet soup;
+    for (const auto& pos : RandomSoup(150, 150, 555)) {
+        soup.insert({pos.X - 75, pos.Y - 75});
+    }
+    auto sparse = MakeGrid(soup, {0, 0}, LifeAlgorithm::SparseLife);
+    auto tiled = MakeGrid(soup, {0, 0}, LifeAlgorithm::TileLife);
+
+    for (int i = 0; i < 200; ++i) {
+        sparse.Update();
+        tiled.Update();
+        ASSERT_EQ(sparse.Data(), tiled.Data()) << "Diverged at generation " << sparse.Generation();
+    }
+    EXPECT_EQ(sparse.Population(), tiled.Population());
+    EXPECT_EQ(sparse.BoundingBox().Pos(), tiled.BoundingBox().Pos());
+}
+
+TEST(TileLifeTest, MatchesSparseLifeBounded) {
+    const auto soup = RandomSoup(100, 70, 8080);
+    auto sparse = MakeGrid(soup, {100, 70}, LifeAlgorithm::SparseLife);
+    auto tiled = MakeGrid(soup, {100, 70}, LifeAlgorithm::TileLife);
+
+    for (int i = 0; i < 150; ++i) {
+        sparse.Update();
+        tiled.Update();
+        ASSERT_EQ(sparse.Data(), tiled.Data()) << "Diverged at generation " << sparse.Generation();
+    }
+}
+
+TEST(LifeKernelTest, VariantsMatchScalar) {
+    std::mt19937_64 rng { 4242 };
+    for (auto isa : { KernelIsa::SSE2, KernelIsa::AVX2, KernelIsa::AVX512 }) {
+        if (!LifeKernel::Supported(isa)) {
+            continue;
+        }
+
+        // Odd row counts exercise the scalar tail of every vector width
+        for (size_t count : { size_t { 1 }, size_t { 7 }, size_t { 64 }, size_t { 67 } }) {
+            std::vector<uint64_t> west(count + 2), middle(count + 2), east(count + 2);
+            for (size_t i = 0; i < count + 2; ++i) {
+                west[i] = rng();
+                middle[i] = rng();
+                east[i] = rng();
+            }
+
+            std::vector<uint64_t> expected(count), actual(count);
+            LifeKernel::Get(KernelIsa::Scalar)(west.data(), middle.data(), east.data(), expected.data(), count);
+            LifeKernel::Get(isa)(west.data(), middle.data(), east.data(), actual.data(), count);
+            EXPECT_EQ(expected, actual) << LifeKernel::ToString(isa) << " with " << count << " rows";
+        }
+    }
+}
+
+TEST(LifeKernelTest, ForcedVariantsMatchSparseLife) {
+    const auto original = LifeKernel::Active();
+    const auto soup = RandomSoup(130, 130, 31337);
+
+    for (auto isa : { KernelIsa::Scalar, KernelIsa::SSE2, KernelIsa::AVX2, KernelIsa::AVX512 }) {
+        if (!LifeKernel::SetActive(isa)) {
+            continue;
+        }
+        EXPECT_EQ(LifeKernel::Active(), isa);
+
+        auto sparse = MakeGrid(soup, {0, 0}, LifeAlgorithm::SparseLife);
+        auto tiled = MakeGrid(soup, {0, 0}, LifeAlgorithm::TileLife);
+        for (int i = 0; i < 40; ++i) {
+            sparse.Update();
+            tiled.Update();
+        }
+        EXPECT_EQ(sparse.Data(), tiled.Data()) << LifeKernel::ToString(isa);
+    }
+    LifeKernel::SetActive(original);
+}
+
+TEST(ThreadPoolTest, ParallelForCoversEveryIndexOnce) {
+    ThreadPool pool { 4 };
+    std::vector<std::atomic<int>> hits(10'000);
+
+    pool.ParallelFor(hits.size(), 37, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            hits[i]++;
+        }
+    });
+    EXPECT_TRUE(std::ranges::all_of(hits, [](const auto& count) { return count.load() == 1; }));
+}
+
+TEST(ThreadPoolTest, NestedGroupsDoNotDeadlock) {
+    ThreadPool pool { 3 };
+    std::atomic<int> leaves = 0;
+
+    ThreadPool::TaskGroup outer;
+    for (int i = 0; i < 8; ++i) {
+        pool.Submit(outer, [&] {
+            ThreadPool::TaskGroup inner;
+            for (int j = 0; j < 8; ++j) {
+                pool.Submit(inner, [&] { leaves++; });
+            }
+            pool.Wait(inner);
+        });
+    }
+    pool.Wait(outer);
+    EXPECT_EQ(leaves.load(), 64);
+}
+
+TEST(TileLifeTest, ParallelMatchesSerial) {
+    LifeHashSet soup;
+    for (const auto& pos : RandomSoup(400, 300, 2024)) {
+        soup.insert({pos.X - 200, pos.Y - 150});
+    }
+
+    for (auto size : { Size2 {0, 0}, Size2 {300, 200} }) {
+        auto serial = MakeGrid(soup, size, LifeAlgorithm::TileLife);
+        auto parallel = MakeGrid(soup, size, LifeAlgorithm::TileLife);
+        parallel.SetThreadCount(4);
+        EXPECT_EQ(serial.ThreadCount(), 1u);
+        EXPECT_EQ(parallel.ThreadCount(), 4u);
+
+        for (int i = 0; i < 100; ++i) {
+            serial.Update();
+            parallel.Update();
+            ASSERT_EQ(serial.Data(), parallel.Data()) << "Diverged at generation " << serial.Generation();
+        }
+    }
+}
+
+TEST(TileLifeTest, OscillatorsOnTileEdgesMatchSparseLife) {
+    // Still lifes and blinkers straddling tile edges and corners, with a glider
+    // flying through them so the skipped tiles get disturbed later on
+    LifeHashSet cells = {
+        {63, 63}, {64, 63}, {63, 64}, {64, 64},
+        {62, 10}, {63, 10}, {64, 10},
+        {10, 127}, {10, 128}, {10, 129},
+        {-1, -2}, {-1, -1}, {-1, 0},
+        {40, 40}, {41, 41}, {39, 42}, {40, 42}, {41, 42},
+    };
+    auto sparse = MakeGrid(cells, {0, 0}, LifeAlgorithm::SparseLife);
+    auto tiled = MakeGrid(cells, {0, 0}, LifeAlgorithm::TileLife);
+
+    for (int i = 0; i < 300; ++i) {
+        sparse.Update();
+        tiled.Update();
+        ASSERT_EQ(sparse.Data(), tiled.Data()) << "Diverged at generation " << sparse.Generation();
+    }
+}
+
+TEST(TileLifeTest, SettledSoupMatchesHashLife) {
+    LifeHashSet soup;
+    for (const auto& pos : RandomSoup(120, 120, 99)) {
+        soup.insert({pos.X - 60, pos.Y - 60});
+    }
+    auto tiled = MakeGrid(soup, {0, 0}, LifeAlgorithm::TileLife);
+    auto hashed = MakeGrid(soup, {0, 0}, LifeAlgorithm::HashLife);
+
+    // Long enough for most tiles to settle into still lifes and blinkers
+    for (int checkpoint = 0; checkpoint < 3; ++checkpoint) {
+        for (int i = 0; i < 500; ++i) {
+            tiled.Update();
+        }
+        hashed.AdvanceBy(500);
+        ASSERT_EQ(tiled.Data(), hashed.Data()) << "Diverged by generation " << tiled.Generation();
+    }
+}
+
+TEST(SweepLifeTest, MatchesSparseLifeWithSortedOutput) {
+    // Negative coordinates exercise the sign flip in the packed keys
+    LifeHashSet soup;
+    for (const auto& pos : RandomSoup(90, 90, 777)) {
+        soup.insert({pos.X - 45, pos.Y - 45});
+    }
+
+    for (auto size : { Size2 {0, 0}, Size2 {60, 70} }) {
+        LifeHashSet cells;
+        for (const auto& pos : soup) {
+            if (size.Width == 0 || Rect(0, 0, size.Width, size.Height).InBounds(pos)) {
+                cells.insert(pos);
+            }
+        }
+        auto sparse = MakeGrid(cells, size, LifeAlgorithm::SparseLife);
+        auto sweep = MakeGrid(cells, size, LifeAlgorithm::SweepLife);
+
+        for (int i = 0; i < 100; ++i) {
+            sparse.Update();
+            sweep.Update();
+            ASSERT_EQ(sparse.Data(), sweep.Data()) << "Diverged at generation " << sparse.Generation();
+        }
+
+        const auto& sorted = sweep.SortedData();
+        EXPECT_TRUE(std::ranges::is_sorted(sorted));
+        EXPECT_EQ(sorted.size(), sweep.Data().size());
+    }
+}
+
+TEST(SweepLifeTest, SortedDataFollowsEdits) {
+    auto grid = MakeGrid({ {0, 0}, {1, 0}, {2, 0} }, {0, 0}, LifeAlgorithm::SweepLife);
+    grid.Update();
+    EXPECT_EQ(grid.SortedData(), (std::vector<Vec2> { {1, -1}, {1, 0}, {1, 1} }));
+
+    grid.TranslateRegion({0, -1, 3, 3}, {10, 0});
+    EXPECT_EQ(grid.SortedData(), (std::vector<Vec2> { {11, -1}, {11, 0}, {11, 1} }));
+
+    grid.Set(-5, 2, true);
+    grid.Update();
+    EXPECT_EQ(grid.SortedData(), (std::vector<Vec2> { {10, 0}, {11, 0}, {12, 0} }));
+}
+
+TEST(SlabArenaTest, NodesAreAlignedAndStable) {
+    static_assert(sizeof(LifeNode) == 32);
+
+    SlabArena<LifeNode> arena { 4 };
+    std::vector<const LifeNode*> nodes;
+    for (int i = 0; i < 10; ++i) {
+        nodes.push_back(arena.Create());
+    }
+
+    // Two nodes share each cache line and none straddles one
+    for (const auto* node : nodes) {
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(node) % sizeof(LifeNode), 0u);
+    }
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(nodes[1]) - reinterpret_cast<uintptr_t>(nodes[0]), sizeof(LifeNode));
+
+    // Indices address the same objects across slabs
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        EXPECT_EQ(&arena[i], nodes[i]);
+    }
+
+    auto stats = arena.MemoryStats();
+    EXPECT_EQ(stats.Objects, 10u);
+    EXPECT_EQ(stats.Slabs, 3u);
+    EXPECT_EQ(stats.BytesUsed, 10 * sizeof(LifeNode));
+    EXPECT_EQ(stats.BytesReserved, 12 * sizeof(LifeNode));
+
+    // Destroyed slots are handed out again before the arena grows
+    arena.Destroy(3);
+    EXPECT_EQ(arena.Emplace(), 3u);
+    EXPECT_EQ(arena.MemoryStats().Slabs, 3u);
+
+    arena.Clear();
+    EXPECT_EQ(arena.MemoryStats().Slabs, 0u);
+}
+
+TEST(SlabArenaTest, HashQuadtreeReportsNodeMemory) {
+    HashQuadtree tree { RandomSoup(64, 64, 12) };
+    const auto before = tree.NodeMemoryStats();
+    EXPECT_GT(before.Objects, 0u);
+    EXPECT_GE(before.BytesReserved, before.BytesUsed);
+
+    tree.Advance({}, 6);
+    EXPECT_GT(tree.NodeMemoryStats().Objects, before.Objects);
+
+    // Copies intern their own nodes
+    HashQuadtree copy = tree;
+    EXPECT_EQ(LifeHashSet(copy.begin(), copy.end()), LifeHashSet(tree.begin(), tree.end()));
+    EXPECT_GT(copy.NodeMemoryStats().Objects, 0u);
+    EXPECT_LE(copy.NodeMemoryStats().Objects, tree.NodeMemoryStats().Objects);
+}
+
+TEST(HashQuadtreeGcTest, CollectionKeepsOnlyReachableNodes) {
+    const auto soup = RandomSoup(48, 48, 5150);
+    HashQuadtree tree { soup };
+    tree.SetMemoryBudget(0);
+    for (int i = 0; i < 64; ++i) {
+        tree.Advance({});
+    }
+    const auto expected = LifeHashSet { tree.begin(), tree.end() };
+    const auto usageBefore = tree.MemoryUsage();
+
+    const auto stats = tree.CollectGarbage();
+    EXPECT_GT(stats.NodesReclaimed, 0u);
+    // The empty leaf lives in the arena but is never collected
+    EXPECT_EQ(stats.NodesRetained + 1, tree.NodeMemoryStats().Objects);
+    EXPECT_EQ(stats.BytesReclaimed, usageBefore - tree.MemoryUsage());
+    EXPECT_EQ(LifeHashSet(tree.begin(), tree.end()), expected);
+
+    // A second pass has nothing left to free
+    EXPECT_EQ(tree.CollectGarbage().NodesReclaimed, 0u);
+
+    auto sparse = MakeGrid(expected, {0, 0}, LifeAlgorithm::SparseLife);
+    for (int i = 0; i < 32; ++i) {
+        tree.Advance({});
+        sparse.Update();
+    }
+    EXPECT_EQ(LifeHashSet(tree.begin(), tree.end()), sparse.Data());
+}
+
+TEST(HashQuadtreeGcTest, PinnedRootsSurviveCollection) {
+    const auto soup = RandomSoup(32, 32, 31337);
+    HashQuadtree tree { soup };
+    tree.SetMemoryBudget(0);
+    const auto pin = tree.PinRoot();
+
+    for (int i = 0; i < 50; ++i) {
+        tree.Advance({});
+    }
+    tree.CollectGarbage();
+
+    tree.RestoreRoot(pin);
+    EXPECT_EQ(LifeHashSet(tree.begin(), tree.end()), soup);
+
+    tree.Advance({}, 4);
+    tree.UnpinRoot(pin);
+    tree.CollectGarbage();
+    EXPECT_GT(tree.LastCollection().NodesReclaimed, 0u);
+
+    auto sparse = MakeGrid(soup, {0, 0}, LifeAlgorithm::SparseLife);
+    for (int i = 0; i < 16; ++i) {
+        sparse.Update();
+    }
+    EXPECT_EQ(LifeHashSet(tree.begin(), tree.end()), sparse.Data());
+}
+
+TEST(HashQuadtreeGcTest, BudgetTriggersCollection) {
+    const auto soup = RandomSoup(64, 64, 2718);
+    HashQuadtree unlimited { soup };
+    unlimited.SetMemoryBudget(0);
+    HashQuadtree budgeted { soup };
+    budgeted.SetMemoryBudget(256 * 1024);
+
+    for (int i = 0; i < 200; ++i) {
+        unlimited.Advance({});
+        budgeted.Advance({});
+    }
+    EXPECT_GT(budgeted.LastCollection().NodesReclaimed, 0u);
+    EXPECT_EQ(unlimited.LastCollection().NodesReclaimed, 0u);
+    EXPECT_LT(budgeted.MemoryUsage(), unlimited.MemoryUsage());
+    EXPECT_EQ(LifeHashSet(budgeted.begin(), budgeted.end()), LifeHashSet(unlimited.begin(), unlimited.end()));
+}
+
+TEST(HashQuadtreeTest, NodeTableIsDeterministic) {
+    const auto soup = RandomSoup(48, 48, 8086);
+    HashQuadtree first { soup };
+    HashQuadtree second { soup };
+    for (int i = 0; i < 20; ++i) {
+        first.Advance({}, 2);
+        second.Advance({}, 2);
+    }
+    EXPECT_EQ(first.NodeMemoryStats().Objects, second.NodeMemoryStats().Objects);
+
+    // Moves keep the node table working
+    HashQuadtree moved = std::move(first);
+    moved.Advance({});
+    second.Advance({});
+    EXPECT_EQ(LifeHashSet(moved.begin(), moved.end()), LifeHashSet(second.begin(), second.end()));
+}
+
+TEST(HashQuadtreeTest, SetEditsOnlyTheCellPath) {
+    auto cells = RandomSoup(256, 256, 4040);
+    HashQuadtree tree(cells);
+    const auto nodesBefore = tree.NodeMemoryStats().Objects;
+
+    tree.Set({100, 37}, !cells.contains({100, 37}));
+    if (cells.contains({100, 37})) {
+        cells.erase({100, 37});
+    } else {
+        cells.insert({100, 37});
+    }
+    VerifyContent(tree, cells);
+
+    // One new leaf plus at most one node per level above it
+    EXPECT_LE(tree.NodeMemoryStats().Objects - nodesBefore, 6u);
+}
+
+TEST(HashQuadtreeTest, SetManyGrowsAndClears) {
+    HashQuadtree tree;
+    const std::vector<Vec2> far = { {-1000, 5}, {0, 0}, {1, 0}, {2, 0}, {70000, -3} };
+    tree.SetMany(far, true);
+    VerifyContent(tree, LifeHashSet(far.begin(), far.end()));
+
+    tree.Set({-1000, 5}, false);
+    tree.Set({123456, 7}, false);
+    VerifyContent(tree, LifeHashSet { {0, 0}, {1, 0}, {2, 0}, {70000, -3} });
+
+    tree.SetMany(far, false);
+    EXPECT_TRUE(tree.empty());
+}
+
+TEST(HashLifeTest, EditsKeepTreeInStep) {
+    const auto soup = RandomSoup(40, 40, 1212);
+    auto sparse = MakeGrid(soup, {0, 0}, LifeAlgorithm::SparseLife);
+    auto hash = MakeGrid(soup, {0, 0}, LifeAlgorithm::HashLife);
+
+    for (int i = 0; i < 20; ++i) {
+        sparse.Update();
+        hash.Update();
+        sparse.Set(i * 3, -i, true);
+        hash.Set(i * 3, -i, true);
+        sparse.ClearData({ {i, i}, {i + 1, i} }, {5, 5});
+        hash.ClearData({ {i, i}, {i + 1, i} }, {5, 5});
+        ASSERT_EQ(sparse.Data(), hash.Data());
+    }
+    sparse.Update();
+    hash.Update();
+    EXPECT_EQ(sparse.Data(), hash.Data());
+}
+
+TEST(HashLifeTest, CellsAreOnlyBuiltWhenRead) {
+    const auto soup = RandomSoup(40, 40, 4242);
+    auto sparse = MakeGrid(soup, {0, 0}, LifeAlgorithm::SparseLife);
+    auto hash = MakeGrid(soup, {0, 0}, LifeAlgorithm::HashLife);
+
+    // Nothing reads the cells between these, so each edit has to work from the tree alone
+    for (int i = 0; i < 10; ++i) {
+        sparse.AdvanceBy(3);
+        hash.AdvanceBy(3);
+        sparse.Toggle(i, -i);
+        hash.Toggle(i, -i);
+        sparse.TranslateRegion({ 0, 0, 10, 10 }, { 1, 2 });
+        hash.TranslateRegion({ 0, 0, 10, 10 }, { 1, 2 });
+        ASSERT_EQ(sparse.Population(), hash.Population());
+        ASSERT_EQ(sparse.Dead(), hash.Dead());
+    }
+
+    sparse.Update();
+    hash.Update();
+    hash.SetAlgorithm(LifeAlgorithm::TileLife);
+    sparse.Update();
+    hash.Update();
+    EXPECT_EQ(sparse.Data(), hash.Data());
+    EXPECT_EQ(sparse.SortedData(), hash.SortedData());
+}
+
+TEST(HashQuadtreeTest, CellsInMatchesFilteredCells) {
+    const auto soup = RandomSoup(200, 150, 6060);
+    LifeHashSet cells;
+    for (const auto& pos : soup) {
+        cells.insert({pos.X - 77, pos.Y - 41});
+    }
+    HashQuadtree tree(cells);
+
+    for (const auto& region : { Rect { -5, -3, 13, 9 }, Rect { -100, -100, 400, 400 }, Rect { 30, 20, 1, 1 }, Rect { 500, 500, 10, 10 } }) {
+        LifeHashSet expected;
+        for (const auto& pos : cells) {
+            if (region.InBounds(pos)) {
+                expected.insert(pos);
+            }
+        }
+        const auto range = tree.CellsIn(region);
+        EXPECT_EQ(LifeHashSet(range.begin(), range.end()), expected);
+    }
+
+    auto grid = MakeGrid(cells, {0, 0}, LifeAlgorithm::HashLife);
+    grid.Update();
+    const auto visible = grid.CellsIn({ 0, 0, 32, 32 });
+    EXPECT_TRUE(std::ranges::all_of(visible, [](Vec2 pos) { return Rect { 0, 0, 32, 32 }.InBounds(pos); }));
+    EXPECT_EQ(visible.size(), grid.ReadRegion({ 0, 0, 32, 32 }).size());
+}
+
+TEST(HashQuadtreeTest, PopulationInMatchesCellCounts) {
+    const auto soup = RandomSoup(180, 120, 7070);
+    LifeHashSet cells;
+    for (const auto& pos : soup) {
+        cells.insert({pos.X - 90, pos.Y - 33});
+    }
+    HashQuadtree tree(cells);
+    EXPECT_EQ(tree.Population(), cells.size());
+
+    for (const auto& region : { Rect { -7, -5, 19, 11 }, Rect { -1000, -1000, 2000, 2000 }, Rect { 3, 4, 1, 1 }, Rect { 400, 400, 8, 8 } }) {
+        const auto expected = std::ranges::count_if(cells, [&](const Vec2& pos) { return region.InBounds(pos); });
+        EXPECT_EQ(tree.PopulationIn(region), static_cast<uint64_t>(expected));
+    }
+
+    tree.Advance({}, 5);
+    LifeHashSet advanced(tree.begin(), tree.end());
+    EXPECT_EQ(tree.Population(), advanced.size());
+    EXPECT_EQ(tree.PopulationIn({ -50, -50, 100, 100 }),
+        static_cast<uint64_t>(std::ranges::count_if(advanced, [](const Vec2& pos) { return Rect { -50, -50, 100, 100 }.InBounds(pos); })));
+}
+
+TEST(LifeRuleTest, ParsesAndPrintsBSNotation) {
+    EXPECT_EQ(LifeRule::Parse("B3/S23"), LifeRules::Conway);
+    EXPECT_EQ(LifeRule::Parse("b36/s23"), LifeRules::HighLife);
+    EXPECT_EQ(LifeRule::Parse("B3678/S34678"), LifeRules::DayAndNight);
+    EXPECT_EQ(LifeRule::Parse("B2/S"), LifeRules::Seeds);
+
+    for (const auto& rule : { LifeRules::Conway, LifeRules::HighLife, LifeRules::DayAndNight, LifeRules::Seeds }) {
+        EXPECT_EQ(LifeRule::Parse(rule.ToString()), rule);
+    }
+    EXPECT_EQ(LifeRules::HighLife.ToString(), "B36/S23");
+
+    EXPECT_FALSE(LifeRule::Parse("B03/S23"));
+    EXPECT_FALSE(LifeRule::Parse("B39/S23"));
+    EXPECT_FALSE(LifeRule::Parse("B3S23"));
+    EXPECT_FALSE(LifeRule::Parse("23/3"));
+}
+
+// One generation of an unbounded Life-like universe, checking every cell next to a live one
+static LifeHashSet ReferenceStep(const LifeHashSet& cells, const LifeRule& rule) {
+    LifeHashSet result;
+    for (const auto& cell : cells) {
+        for (int32_t dy = -1; dy <= 1; ++dy) {
+            for (int32_t dx = -1; dx <= 1; ++dx) {
+                const Vec2 pos { cell.X + dx, cell.Y + dy };
+                int32_t neighbors = 0;
+                for (int32_t ny = -1; ny <= 1; ++ny) {
+                    for (int32_t nx = -1; nx <= 1; ++nx) {
+                        neighbors += (nx != 0 || ny != 0) && cells.contains({ pos.X + nx, pos.Y + ny });
+                    }
+                }
+                if (cells.contains(pos) ? rule.Survives(neighbors) : rule.Born(neighbors)) {
+                    result.insert(pos);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+TEST(LifeRuleTest, EnginesMatchReferenceUnderOtherRules) {
+    const auto soup = RandomSoup(40, 40, 8080);
+    const std::array rules = {
+        LifeRules::HighLife, LifeRules::DayAndNight, LifeRules::Seeds,
+        *LifeRule::Parse("B36/S125"), *LifeRule::Parse("B3/S012345678")
+    };
+    const std::array algorithms = { LifeAlgorithm::SparseLife, LifeAlgorithm::SweepLife, LifeAlgorithm::TileLife, LifeAlgorithm::HashLife };
+
+    for (const auto& rule : rules) {
+        auto expected = soup;
+        for (int i = 0; i < 6; ++i) {
+            expected = ReferenceStep(expected, rule);
+        }
+
+        for (const auto algorithm : algorithms) {
+            auto grid = MakeGrid(soup, {0, 0}, algorithm);
+            grid.SetRule(rule);
+            for (int i = 0; i < 6; ++i) {
+                grid.Update();
+            }
+            EXPECT_EQ(grid.Data(), expected) << rule.ToString() << " with algorithm " << static_cast<int>(algorithm);
+        }
+    }
+}
+
+TEST(LifeRuleTest, HashLifeJumpsFollowTheRule) {
+    const auto soup = RandomSoup(32, 32, 9090);
+    auto stepped = MakeGrid(soup, {0, 0}, LifeAlgorithm::SparseLife);
+    auto jumped = MakeGrid(soup, {0, 0}, LifeAlgorithm::HashLife);
+    stepped.SetRule(LifeRules::HighLife);
+    jumped.SetRule(LifeRules::HighLife);
+
+    for (int i = 0; i < 100; ++i) {
+        stepped.Update();
+    }
+    jumped.AdvanceBy(100);
+    EXPECT_EQ(stepped.Data(), jumped.Data());
+
+    // Switching rules must not reuse results memoized under the old one
+    stepped.SetRule(LifeRules::Conway);
+    jumped.SetRule(LifeRules::Conway);
+    for (int i = 0; i < 100; ++i) {
+        stepped.Update();
+    }
+    jumped.AdvanceBy(100);
+    EXPECT_EQ(stepped.Data(), jumped.Data());
+}
+
+TEST(RLEEncoderTest, FilesKeepTheirRule) {
+    const auto path = std::filesystem::temp_directory_path() / "gol_rule_round_trip.gol";
+    auto grid = MakeGrid(RandomSoup(20, 12, 1234), {20, 12}, LifeAlgorithm::SparseLife);
+    grid.SetRule(LifeRules::HighLife);
+    ASSERT_TRUE(RLEEncoder::WriteRegion(grid, { 0, 0, 20, 12 }, path));
+
+    const auto loaded = RLEEncoder::ReadRegion(path);
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(loaded->Grid.Rule(), LifeRules::HighLife);
+    EXPECT_EQ(loaded->Grid.Data(), grid.Data());
+
+    std::ofstream { path } << "#B0/S23\n";
+    EXPECT_FALSE(RLEEncoder::ReadRegion(path));
+    std::filesystem::remove(path);
+}
+
+TEST(CycleDetectorTest, OscillatorsAreDetectedAndFastForwarded) {
+    // A blinker and a toad are both period 2, a block is period 1, and the pulsar is period 3
+    LifeHashSet cells = { {0, 1}, {1, 1}, {2, 1}, {10, 10}, {10, 11}, {11, 10}, {11, 11} };
+    for (const auto& pos : { Vec2 {2, 0}, {3, 0}, {4, 0}, {8, 0}, {9, 0}, {10, 0},
+                             {0, 2}, {5, 2}, {7, 2}, {12, 2}, {0, 3}, {5, 3}, {7, 3}, {12, 3}, {0, 4}, {5, 4}, {7, 4}, {12, 4},
+                             {2, 5}, {3, 5}, {4, 5}, {8, 5}, {9, 5}, {10, 5} }) {
+        cells.insert({ pos.X + 30, pos.Y + 30 });
+        cells.insert({ pos.X + 30, 12 - pos.Y + 30 });
+    }
+
+    for (const auto algorithm : { LifeAlgorithm::SparseLife, LifeAlgorithm::HashLife }) {
+        auto grid = MakeGrid(cells, {0, 0}, algorithm);
+        auto reference = MakeGrid(cells, {0, 0}, LifeAlgorithm::SparseLife);
+        for (int i = 0; i < 20; ++i) {
+            grid.Update();
+            reference.Update();
+        }
+        ASSERT_EQ(grid.DetectedPeriod(), 6) << static_cast<int>(algorithm);
+
+        for (int i = 0; i < 7; ++i) {
+            grid.Update();
+            reference.Update();
+            EXPECT_EQ(grid.Data(), reference.Data());
+        }
+        grid.AdvanceBy(1001);
+        for (int i = 0; i < 1001; ++i) {
+            reference.Update();
+        }
+        EXPECT_EQ(grid.Generation(), reference.Generation());
+        EXPECT_EQ(grid.Data(), reference.Data());
+        EXPECT_EQ(grid.Population(), reference.Population());
+
+        grid.Set(100, 100, true);
+        EXPECT_FALSE(grid.DetectedPeriod());
+    }
+}
+
+TEST(CycleDetectorTest, GrowingPatternsAreNotCycles) {
+    LifeHashSet glider = { {1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2} };
+    auto grid = MakeGrid(glider, {0, 0}, LifeAlgorithm::HashLife);
+    for (int i = 0; i < 200; ++i) {
+        grid.Update();
+    }
+    EXPECT_FALSE(grid.DetectedPeriod());
+}
+
+TEST(CycleDetectorTest, CyclesAreFoundThroughGrowingBatches) {
+    const LifeHashSet blinker = { {0, 1}, {1, 1}, {2, 1} };
+    const LifeHashSet vertical = { {1, 0}, {1, 1}, {1, 2} };
+
+    // Batches double the way they do at maximum speed, which used to drop every candidate
+    for (const auto algorithm : { LifeAlgorithm::SparseLife, LifeAlgorithm::TileLife, LifeAlgorithm::HashLife }) {
+        auto grid = MakeGrid(blinker, {0, 0}, algorithm);
+        uint64_t batch = 1;
+        for (int i = 0; i < 40; ++i, batch *= 2) {
+            grid.AdvanceBy(batch);
+        }
+        EXPECT_EQ(grid.DetectedPeriod(), 2) << static_cast<int>(algorithm);
+        EXPECT_EQ(grid.Generation(), static_cast<int64_t>(batch - 1));
+        EXPECT_EQ(grid.Data(), grid.Generation() % 2 == 0 ? blinker : vertical);
+    }
+}
+
+TEST(CycleDetectorTest, PeriodsFoundAcrossJumpsAreReduced) {
+    const std::array<LifeHashSet, 3> cycle = { LifeHashSet { {0, 0} }, LifeHashSet { {1, 0} }, LifeHashSet { {2, 0} } };
+    const auto record = [&cycle](CycleDetector& detector, int64_t generation) {
+        const auto& cells = cycle[static_cast<size_t>(generation % 3)];
+        detector.Record(generation, CycleDetector::Fingerprint(cells), cells);
+    };
+
+    // Unrelated states, until the detector has watched long enough to allow jumps
+    CycleDetector detector;
+    for (int32_t generation = 0; generation < 2 * CycleDetector::MaxPeriod; ++generation) {
+        const LifeHashSet cells = { {generation, 1} };
+        detector.Record(generation, CycleDetector::Fingerprint(cells), cells);
+    }
+    EXPECT_FALSE(detector.NeedsEveryGeneration());
+
+    // Two jumps of 6 land on the same state, which is confirmed one generation at a time
+    record(detector, 300);
+    record(detector, 306);
+    EXPECT_TRUE(detector.NeedsEveryGeneration());
+    for (int64_t generation = 307; generation <= 312; ++generation) {
+        record(detector, generation);
+    }
+    ASSERT_EQ(detector.Period(), 3);
+    EXPECT_EQ(detector.StateAt(1000), cycle[1000 % 3]);
+}
+
+TEST(CycleDetectorTest, LongJumpsRearmInsteadOfMatching) {
+    const LifeHashSet block = { {0, 0}, {1, 0}, {0, 1}, {1, 1} };
+    CycleDetector detector;
+
+    // A match further back than MaxPeriod would make the candidate keep a state per generation
+    detector.Record(100, CycleDetector::Fingerprint(block), block);
+    detector.Record(100 + 4 * CycleDetector::MaxPeriod, CycleDetector::Fingerprint(block), block);
+    EXPECT_EQ(detector.KeptStates(), 0u);
+    EXPECT_TRUE(detector.NeedsEveryGeneration());
+
+    detector.Record(101 + 4 * CycleDetector::MaxPeriod, CycleDetector::Fingerprint(block), block);
+    detector.Record(102 + 4 * CycleDetector::MaxPeriod, CycleDetector::Fingerprint(block), block);
+    EXPECT_EQ(detector.Period(), 1);
+    EXPECT_EQ(detector.KeptStates(), 1u);
+}
+
+TEST(CycleDetectorTest, PatternsSettlingDuringAJumpAreFound) {
+    // Settles into period 2 around generation 460, well inside the first jump, next to 1600 cells
+    // of blocks that make every kept state expensive
+    auto soup = RandomSoup(10, 10, 76);
+    for (int32_t x = 0; x < 20; ++x) {
+        for (int32_t y = 0; y < 20; ++y) {
+            soup.insert({ 200 + x * 4, y * 4 });
+            soup.insert({ 201 + x * 4, y * 4 });
+            soup.insert({ 200 + x * 4, y * 4 + 1 });
+            soup.insert({ 201 + x * 4, y * 4 + 1 });
+        }
+    }
+    auto grid = MakeGrid(soup, {0, 0}, LifeAlgorithm::HashLife);
+    auto reference = MakeGrid(soup, {0, 0}, LifeAlgorithm::TileLife);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 3; ++i) {
+        grid.AdvanceBy(65536);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    reference.AdvanceBy(3 * 65536);
+
+    EXPECT_EQ(grid.DetectedPeriod(), 2);
+    EXPECT_EQ(grid.Generation(), 3 * 65536);
+    EXPECT_EQ(grid.Data(), reference.Data());
+
+    // Checking the whole jump one generation at a time took seconds and gigabytes
+    EXPECT_LT(elapsed, std::chrono::seconds { 2 });
+}
+
+TEST(HashLifeTest, ParallelMatchesSerial) {
+    const auto soup = RandomSoup(300, 300, 4242);
+    HashQuadtree serial { soup };
+    HashQuadtree parallel { soup };
+    ThreadPool pool { 4 };
+
+    for (int i = 0; i < 8; ++i) {
+        serial.Advance({});
+        parallel.Advance({}, 0, &pool);
+    }
+    EXPECT_EQ(LifeHashSet(parallel.begin(), parallel.end()), LifeHashSet(serial.begin(), serial.end()));
+
+    serial.Advance({}, 9);
+    parallel.Advance({}, 9, &pool);
+    EXPECT_EQ(LifeHashSet(parallel.begin(), parallel.end()), LifeHashSet(serial.begin(), serial.end()));
+    EXPECT_EQ(parallel.Population(), serial.Population());
+}
+
+// Objects for the intern table tests, where an object is just its key
+struct InternedKeys {
+    explicit InternedKeys(size_t capacity) : Keys(capacity) {}
+
+    std::vector<uint64_t> Keys;
+    std::atomic<uint32_t> NextId = 1;
+    std::atomic<size_t> Discarded = 0;
+
+    // Pairs of keys share a hash, so lookups have to compare keys
+    static uint64_t Hash(uint64_t key) { return HashCombine(0, key / 2); }
+
+    uint32_t Intern(ConcurrentInternTable& table, uint64_t key) {
+        return table.FindOrInsert(Hash(key),
+            [&](uint32_t id) { return Keys[id] == key; },
+            [&] {
+                const auto id = NextId.fetch_add(1, std::memory_order_relaxed);
+                Keys[id] = key;
+                return id;
+            },
+            [&](uint32_t) { Discarded.fetch_add(1, std::memory_order_relaxed); });
+    }
+};
+
+TEST(ConcurrentInternTableTest, ConcurrentInsertsInternEachKeyOnce) {
+    constexpr size_t keyCount = 20000;
+    constexpr size_t threadCount = 8;
+
+    // Starts tiny so the threads run into several resizes
+    ConcurrentInternTable table { 16 };
+    InternedKeys objects { keyCount * threadCount + 1 };
+
+    std::vector<std::vector<uint32_t>> ids(threadCount, std::vector<uint32_t>(keyCount));
+    {
+        std::vector<std::jthread> threads;
+        for (size_t t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&, t] {
+                std::vector<uint64_t> order(keyCount);
+                std::iota(order.begin(), order.end(), uint64_t { 0 });
+                std::ranges::shuffle(order, std::mt19937 { static_cast<uint32_t>(t) });
+                for (const auto key : order) {
+                    ids[t][key] = objects.Intern(table, key);
+                }
+            });
+        }
+    }
+
+    for (size_t key = 0; key < keyCount; ++key) {
+        for (size_t t = 1; t < threadCount; ++t) {
+            ASSERT_EQ(ids[t][key], ids[0][key]) << "Key " << key << " was interned twice";
+        }
+        EXPECT_EQ(objects.Keys[ids[0][key]], key);
+    }
+    EXPECT_EQ(table.size(), keyCount);
+    EXPECT_EQ(objects.NextId - 1, keyCount + objects.Discarded);
+    EXPECT_GE(table.Capacity(), 2 * keyCount);
+
+    // Every key is still found after the resizes, and erasing keeps the rest findable
+    const auto erased = table.EraseIf([&](uint32_t id) { return objects.Keys[id] % 3 == 0; });
+    EXPECT_EQ(erased, (keyCount + 2) / 3);
+    EXPECT_EQ(table.size(), keyCount - erased);
+    for (uint64_t key = 0; key < keyCount; ++key) {
+        const auto found = table.Find(InternedKeys::Hash(key), [&](uint32_t id) { return objects.Keys[id] == key; });
+        EXPECT_EQ(found, key % 3 == 0 ? ConcurrentInternTable::NoId : ids[0][key]);
+    }
+}
+
+// Interns each key twice, so half the calls are hits, and reports millions of calls per second
+TEST(ConcurrentInternTableTest, DISABLED_ThroughputAgainstUnorderedDense) {
+    constexpr size_t keyCount = size_t { 1 } << 21;
+    std::vector<uint64_t> keys(keyCount * 2);
+    std::iota(keys.begin(), keys.begin() + keyCount, uint64_t { 0 });
+    std::iota(keys.begin() + keyCount, keys.end(), uint64_t { 0 });
+    std::ranges::shuffle(keys, std::mt19937 { 7 });
+
+    const auto report = [&](const char* name, auto&& run) {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+        std::cout << name << ": " << keys.size() / seconds.count() / 1e6 << " M interns/s" << std::endl;
+    };
+
+    report("unordered_dense::set", [&] {
+        InternedKeys objects { keyCount + 1 };
+        struct Hash {
+            using is_transparent = void;
+            const InternedKeys* Objects;
+            uint64_t operator()(uint32_t id) const { return InternedKeys::Hash(Objects->Keys[id]); }
+            uint64_t operator()(uint64_t key) const { return InternedKeys::Hash(key); }
+        };
+        struct Equal {
+            using is_transparent = void;
+            const InternedKeys* Objects;
+            bool operator()(uint32_t a, uint32_t b) const { return a == b; }
+            bool operator()(uint64_t key, uint32_t id) const { return Objects->Keys[id] == key; }
+        };
+        ankerl::unordered_dense::set<uint32_t, Hash, Equal> set { 0, Hash { &objects }, Equal { &objects } };
+        for (const auto key : keys) {
+            if (!set.contains(key)) {
+                const auto id = objects.NextId++;
+                objects.Keys[id] = key;
+                set.insert(id);
+            }
+        }
+        EXPECT_EQ(set.size(), keyCount);
+    });
+
+    for (const auto threadCount : { 1u, std::max(std::thread::hardware_concurrency(), 2u) }) {
+        const auto name = "ConcurrentInternTable x" + std::to_string(threadCount);
+        report(name.c_str(), [&] {
+            InternedKeys objects { keyCount * threadCount + 1 };
+            ConcurrentInternTable table;
+            std::vector<std::jthread> threads;
+            for (size_t t = 0; t < threadCount; ++t) {
+                threads.emplace_back([&, t] {
+                    for (size_t i = t; i < keys.size(); i += threadCount) {
+                        objects.Intern(table, keys[i]);
+                    }
+                });
+            }
+            threads.clear();
+            EXPECT_EQ(table.size(), keyCount);
+        });
+    }
+}
+
+// Polls until the worker hands the grid back, failing after a generous timeout
+static std::optional<GameGrid> WaitForGrid(SimulationWorker& worker) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds { 10 };
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (auto grid = worker.TryReclaim()) {
+            return grid;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds { 1 });
+    }
+    return std::nullopt;
+}
+
+TEST(SimulationWorkerTest, StepsOffThreadAndHandsTheGridBack) {
+    const LifeHashSet glider = { {1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2} };
+    SimulationWorker worker;
+
+    // Steps are taken on the worker, and the snapshot matches the returned grid
+    worker.Step(MakeGrid(glider, {0, 0}, LifeAlgorithm::SparseLife), 8);
+    EXPECT_TRUE(worker.HoldsGrid());
+    auto grid = WaitForGrid(worker);
+    ASSERT_TRUE(grid);
+    EXPECT_FALSE(worker.HoldsGrid());
+    EXPECT_EQ(grid->Generation(), 8);
+    EXPECT_EQ(worker.AcquireLatest().Generation, 8);
+    EXPECT_EQ(worker.Latest().Cells, grid->SortedData());
+
+    // Running grids keep publishing generations until paused. The long delay keeps the worker from
+    // stepping before the starting generation has been checked.
+    worker.SetTickDelay(60'000.);
+    worker.Start(std::move(*grid));
+    EXPECT_EQ(worker.AcquireLatest().Generation, 8);
+    worker.SetTickDelay(1.);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds { 10 };
+    while (worker.AcquireLatest().Generation < 20 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds { 1 });
+    }
+    worker.Pause();
+    grid = WaitForGrid(worker);
+    ASSERT_TRUE(grid);
+    EXPECT_GE(grid->Generation(), 20);
+    EXPECT_EQ(worker.AcquireLatest().Generation, grid->Generation());
+    EXPECT_EQ(grid->Population(), 5);
+
+    // Only cells in the requested columns are returned
+    const auto& cells = worker.Latest().Cells;
+    const auto left = cells.front().X + 1;
+    for (const auto& cell : worker.Latest().CellsInColumns(left, left + 1)) {
+        EXPECT_EQ(cell.X, left);
+    }
+    EXPECT_EQ(worker.Latest().CellsInColumns(left, left + 1).size(),
+        static_cast<size_t>(std::ranges::count(cells, left, &Vec2::X)));
+}
+
+TEST(SimulationWorkerTest, LongStepsCanBePaused) {
+    // SparseLife steps a glider one generation at a time and it never cycles, so this step would take hours
+    const LifeHashSet glider = { {1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2} };
+    constexpr uint64_t generations = 1'000'000'000'000;
+    SimulationWorker worker;
+    worker.SetFrameBudget(2.);
+
+    // Progress is published between batches, and pausing hands back the generations done so far
+    worker.Step(MakeGrid(glider, {0, 0}, LifeAlgorithm::SparseLife), generations);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds { 10 };
+    while (worker.AcquireLatest().Generation == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds { 1 });
+    }
+    worker.Pause();
+    auto grid = WaitForGrid(worker);
+    ASSERT_TRUE(grid);
+    EXPECT_GT(grid->Generation(), 0);
+    EXPECT_LT(grid->Generation(), static_cast<int64_t>(generations));
+    EXPECT_EQ(grid->Population(), 5);
+    worker.AcquireLatest();
+    EXPECT_EQ(worker.Latest().Generation, grid->Generation());
+
+    // Destroying a worker part way through a step stops it after the batch in progress
+    const auto start = std::chrono::steady_clock::now();
+    {
+        SimulationWorker stepping;
+        stepping.Step(std::move(*grid), generations);
+        std::this_thread::sleep_for(std::chrono::milliseconds { 20 });
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds { 5 });
+}
+
+TEST(SimulationWorkerTest, MaxSpeedRunsBatchesOfGenerations) {
+    const LifeHashSet blinker = { {0, 1}, {1, 1}, {2, 1} };
+    SimulationWorker worker;
+    worker.SetFrameBudget(2.);
+
+    // Once the blinker's cycle is found, batches grow until a frame covers millions of generations.
+    // The deadline only guards against a hang, however slow the build.
+    worker.Start(MakeGrid(blinker, {0, 0}, LifeAlgorithm::SparseLife));
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds { 60 };
+    const auto running = [&worker] {
+        const auto& latest = worker.AcquireLatest();
+        return latest.Generation < 100'000'000 || latest.GenerationsPerSecond == 0.;
+    };
+    while (running() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds { 1 });
+    }
+    EXPECT_GT(worker.Latest().GenerationsPerSecond, 0.);
+    worker.Pause();
+    auto grid = WaitForGrid(worker);
+    ASSERT_TRUE(grid);
+    EXPECT_EQ(grid->DetectedPeriod(), 2);
+    EXPECT_GE(grid->Generation(), 100'000'000);
+    EXPECT_EQ(grid->Population(), 3);
+
+    // A tick delay waits for its ticks instead of running batches, so nothing happens before the first
+    worker.SetTickDelay(60'000.);
+    const auto before = grid->Generation();
+    worker.Start(std::move(*grid));
+    worker.Pause();
+    grid = WaitForGrid(worker);
+    ASSERT_TRUE(grid);
+    EXPECT_EQ(grid->Generation(), before);
+}
+
+TEST(SimulationClockTest, KeepsTheTickRateExactly) {
+    using namespace std::chrono_literals;
+    SimulationClock clock { 1ms };
+
+    // Partial ticks carry over
+    uint64_t ticks = 0;
+    for (int i = 0; i < 5; ++i) {
+        ticks += clock.Advance(400us);
+    }
+    EXPECT_EQ(ticks, 2u);
+    EXPECT_EQ(clock.UntilNextTick(), 1ms);
+
+    // However the time is sliced, a long run gets exactly one tick per millisecond
+    std::mt19937 rng { 99 };
+    std::uniform_int_distribution<int64_t> slice { 0, 3'000'000 };
+    SimulationClock::Duration total {};
+    ticks = 0;
+    for (int i = 0; i < 100000; ++i) {
+        const SimulationClock::Duration elapsed { slice(rng) };
+        total += elapsed;
+        ticks += clock.Advance(elapsed);
+    }
+    EXPECT_EQ(ticks, static_cast<uint64_t>(total / 1ms));
+}
+
+TEST(SimulationClockTest, CatchUpIsCapped) {
+    using namespace std::chrono_literals;
+    SimulationClock clock { 1ms, 50ms };
+
+    // A long stall only catches up on the capped amount, and the rest is dropped
+    EXPECT_EQ(clock.Advance(10s), 50u);
+    EXPECT_EQ(clock.Advance(0ms), 0u);
+
+    // Ticks longer than the cap still happen
+    clock.SetTick(200ms);
+    EXPECT_EQ(clock.Advance(150ms), 0u);
+    EXPECT_EQ(clock.Advance(10s), 1u);
+}
+
+TEST(TripleBufferTest, ConsumerOnlySeesTheNewestValue) {
+    TripleBuffer<int> buffer;
+    buffer.Back() = 1;
+    buffer.Publish();
+    buffer.Back() = 2;
+    buffer.Publish();
+
+    // The first value was replaced before it was picked up
+    EXPECT_TRUE(buffer.HasFresh());
+    EXPECT_EQ(buffer.Acquire(), 2);
+    EXPECT_FALSE(buffer.HasFresh());
+    EXPECT_EQ(buffer.Acquire(), 2);
+
+    // Values arrive in order across threads, even when most of them are dropped
+    constexpr int count = 100000;
+    std::jthread producer([&] {
+        for (int i = 3; i <= count; ++i) {
+            buffer.Back() = i;
+            buffer.Publish();
+        }
+    });
+    int last = 2;
+    while (last < count) {
+        const auto value = buffer.Acquire();
+        ASSERT_GE(value, last);
+        last = value;
+    }
+    EXPECT_EQ(buffer.Front(), count);
+}
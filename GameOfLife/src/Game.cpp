@@ -83,6 +83,8 @@ void gol::Game::Begin()
         UpdateEditors(controlResult, presetResult);
 
         EndFrame();
+        m_Idle = ImGui::GetTime() - m_LastInputTime > InputSettleSeconds
+            && std::ranges::none_of(m_Editors, &SimulationEditor::IsSimulating);
         if (glfwWindowShouldClose(m_Window.Get()))
             glfwSetWindowShouldClose(m_Window.Get(), WindowCanClose());
     }
@@ -203,12 +205,21 @@ void gol::Game::InitImGUI(const std::filesystem::path& stylePath)
 
 void gol::Game::BeginFrame()
 {
-    GL_DEBUG(glfwPollEvents());
+    if (m_Idle)
+    {
+        GL_DEBUG(glfwWaitEventsTimeout(IdleFrameSeconds));
+    }
+    else
+    {
+        GL_DEBUG(glfwPollEvents());
+    }
     GL_DEBUG(glClear(GL_COLOR_BUFFER_BIT));
 
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
+    if (!ImGui::GetCurrentContext()->InputEventsTrail.empty())
+        m_LastInputTime = ImGui::GetTime();
 
     ImGui::PushFont(m_Font, 30.0f);
     CreateDockspace();
@@ -41,6 +41,13 @@ namespace gol
 		static constexpr int32_t DefaultWindowHeight = 1080;
 		static constexpr int32_t DefaultGridWidth = 0;
 		static constexpr int32_t DefaultGridHeight = 0;
+
+		// ImGui keeps animating for a while after input, with hover delays and popups fading in,
+		// so frames keep coming for this long after the last event
+		static constexpr double InputSettleSeconds = 0.5;
+
+		// While idle, a frame is still drawn this often, so anything else time based catches up
+		static constexpr double IdleFrameSeconds = 0.5;
 	public:
 		Game(const std::filesystem::path& configPath);
 		~Game();
@@ -91,6 +98,10 @@ namespace gol
 		ImFont* m_Font = nullptr;
 
 		bool m_Startup = true;
+
+		// Set once nothing is simulating and input has settled, so the next frame waits for events
+		bool m_Idle = false;
+		double m_LastInputTime = 0.;
 	};
 }
 
@@ -86,6 +86,19 @@ gol::PresetDisplay::PresetDisplay(const GameGrid& grid, const std::string& fileN
     )
 { }
 
+void gol::PresetDisplay::Draw(const GraphicsHandlerArgs& args, bool highlighted)
+{
+    Graphics.RescaleFrameBuffer(args.ViewportBounds, args.ViewportBounds);
+    Graphics.CenterCamera(args);
+    Graphics.ClearBackground(args);
+    Graphics.DrawGrid({ 0, 0 }, Grid.Data(), args);
+    if (highlighted)
+        Graphics.DrawSelection({ { 0, 0 }, args.GridSize }, args);
+
+    Drawn = true;
+    Highlighted = highlighted;
+}
+
 gol::PresetSelection::PresetSelection(const std::filesystem::path& defaultPath, Size2 windowSize)
 	: m_DefaultPath(defaultPath)
     , m_WindowSize(windowSize)
@@ -140,16 +153,6 @@ gol::PresetSelectionResult gol::PresetSelection::Update()
             .ShowGridLines = false
         };
 
-        m_Library[i].Graphics.RescaleFrameBuffer(windowBounds, windowBounds);
-        m_Library[i].Graphics.CenterCamera(graphicsArgs);
-        m_Library[i].Graphics.ClearBackground(graphicsArgs);
-
-        m_Library[i].Graphics.DrawGrid(
-            { 0, 0 },
-            m_Library[i].Grid.Data(),
-            graphicsArgs
-        );
-
         if (numAvailable % TemplatesPerRow != 0)
             ImGui::SameLine();
         cursorPos = ImGui::GetCursorPos();
@@ -169,8 +172,10 @@ gol::PresetSelectionResult gol::PresetSelection::Update()
             retString = RLEEncoder::EncodeRegion(m_Library[i].Grid, {{0, 0}, m_Library[i].Grid.Size()}).c_str();
         }
 
-        if (ImGui::IsItemHovered())
-            m_Library[i].Graphics.DrawSelection({ {0, 0}, graphicsArgs.GridSize }, graphicsArgs);
+        // The image is only sampled when ImGui renders, so drawing it after submitting it still shows this frame
+        const bool hovered = ImGui::IsItemHovered();
+        if (!m_Library[i].Drawn || m_Library[i].Highlighted != hovered)
+            m_Library[i].Draw(graphicsArgs, hovered);
 
         numAvailable++;
     }
@@ -19,7 +19,13 @@ namespace gol
 		std::string FileName;
 		GraphicsHandler Graphics;
 
+		// Presets never change, so a thumbnail is only redrawn when it is highlighted or unhighlighted
+		bool Drawn = false;
+		bool Highlighted = false;
+
 		PresetDisplay(const GameGrid& grid, const std::string& fileName, Size2 windowSize);
+
+		void Draw(const GraphicsHandlerArgs& args, bool highlighted);
 	};
 
 	class SearchString
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <filesystem>
@@ -10,6 +11,7 @@
 #include <limits>
 #include <locale>
 #include <optional>
+#include <ranges>
 #include <string>
 #include <utility>
 #include <variant>
@@ -28,7 +30,7 @@
 gol::SimulationEditor::SimulationEditor(uint32_t id, const std::filesystem::path& path, Size2 windowSize, Size2 gridSize)
     : m_EditorID(id)
     , m_CurrentFilePath(path)
-    , m_Grid(gridSize)
+    , m_Grid(gridSize, GameGrid::PreferredAlgorithm(gridSize))
     , m_Graphics(
         std::filesystem::path("resources") / "shader", 
         windowSize.Width, windowSize.Height,
@@ -51,21 +53,13 @@ bool gol::SimulationEditor::operator==(const SimulationEditor& other) const
 
 gol::EditorResult gol::SimulationEditor::Update(std::optional<bool> activeOverride, const SimulationControlResult& controlArgs, const PresetSelectionResult& presetArgs)
 {
+    const bool wasHovered = m_TakeMouseInput;
     auto displayResult = DisplaySimulation((controlArgs.Action || !presetArgs.ClipboardText.empty()) && activeOverride && (*activeOverride));
     if (!displayResult.Visible || (activeOverride && !(*activeOverride)))
         return { .Active = false, .Closing = displayResult.Closing };
 
-    const auto graphicsArgs = GraphicsHandlerArgs
-    { 
-        .ViewportBounds = ViewportBounds(), 
-        .GridSize = m_Grid.Size(),
-		.CellSize = { SimulationEditor::DefaultCellWidth, SimulationEditor::DefaultCellHeight },
-		.ShowGridLines = controlArgs.GridLines
-    };
     UpdateViewport();
     UpdateDragState();
-    m_Graphics.RescaleFrameBuffer(WindowBounds(), ViewportBounds());
-    m_Graphics.ClearBackground(graphicsArgs);
 
     auto pasteWarnResult = m_PasteWarning.Update();
     if (pasteWarnResult == PopupWindowState::Success)
@@ -73,43 +67,89 @@ gol::EditorResult gol::SimulationEditor::Update(std::optional<bool> activeOverri
         auto pasteResult = m_SelectionManager.Paste(CursorGridPos(), std::numeric_limits<uint32_t>::max());
         if (pasteResult)
             m_VersionManager.PushChange(*pasteResult);
+        m_Dirty = true;
     }
     m_FileErrorWindow.Update();
     
     if (presetArgs.ClipboardText.length() > 0) 
     {
 		ImGui::SetClipboardText(presetArgs.ClipboardText.c_str());
-        m_VersionManager.TryPushChange(m_SelectionManager.Deselect(m_Grid));
+        if (!m_Worker->HoldsGrid())
+            m_VersionManager.TryPushChange(m_SelectionManager.Deselect(m_Grid));
         auto result = m_SelectionManager.Paste(Vec2{ 0, 0 }, std::numeric_limits<uint32_t>::max(), true);
         if (result)
             m_VersionManager.PushChange(*result);
+        m_Dirty = true;
 	}
 
-    if (controlArgs.TickDelayMs)
+    // Sent every frame, but only changes are passed on, so an idle worker is not woken for nothing
+    if (controlArgs.TickDelayMs && *controlArgs.TickDelayMs != m_TickDelayMs)
+    {
         m_TickDelayMs = *controlArgs.TickDelayMs;
+        m_Worker->SetTickDelay(m_TickDelayMs);
+    }
 
+    ReclaimGrid();
+    if (m_Worker->HasNewGeneration())
+        m_Dirty = true;
+    m_Worker->AcquireLatest();
     if (controlArgs.Action && ((activeOverride && *activeOverride) || displayResult.Selected))
-        m_State = UpdateState(controlArgs);
+    {
+        // Every action needs the grid, so while the worker has it the action waits for it to be handed back
+        if (m_Worker->HoldsGrid())
+        {
+            m_Worker->Pause();
+            m_DeferredAction = controlArgs;
+        }
+        else
+        {
+            m_State = UpdateState(controlArgs);
+            m_Dirty = true;
+        }
+    }
 
-    m_State = [this, &graphicsArgs]()
+    m_State = [this]()
     {
+        if (m_State != SimulationState::Simulation && m_Worker->HoldsGrid())
+            return m_State;
+
         switch (m_State)
         {
         using enum SimulationState;
         case Simulation:
-            return SimulationUpdate(graphicsArgs);
+            return SimulationUpdate();
         case Paint:
-            return PaintUpdate(graphicsArgs);
+            return PaintUpdate();
         case Paused:
-            return PauseUpdate(graphicsArgs);
+            return PauseUpdate();
         case Empty:
-            return PaintUpdate(graphicsArgs);
+            return PaintUpdate();
         case None:
             return Empty;
         };
         std::unreachable();
     }();
 
+    // Painting and selecting only happen under the cursor, so input elsewhere leaves the grid as it was.
+    // The frame the cursor leaves still counts, since leaving can reset the selection.
+    if ((m_TakeMouseInput || wasHovered) && !ImGui::GetCurrentContext()->InputEventsTrail.empty())
+        m_Dirty = true;
+
+    const auto view = ViewState { ViewportBounds(), m_Graphics.Camera, controlArgs.GridLines };
+    if (std::exchange(m_LastView, view) != view)
+        m_Dirty = true;
+
+    if (std::exchange(m_Dirty, false))
+    {
+        Render(GraphicsHandlerArgs
+        {
+            .ViewportBounds = view.ViewportBounds,
+            .GridSize = m_Grid.Size(),
+            .CellSize = { SimulationEditor::DefaultCellWidth, SimulationEditor::DefaultCellHeight },
+            .ShowGridLines = view.ShowGridLines
+        });
+    }
+
     return 
     { 
         .CurrentFilePath = m_CurrentFilePath,
@@ -119,44 +159,43 @@ gol::EditorResult gol::SimulationEditor::Update(std::optional<bool> activeOverri
         .SelectionActive = m_SelectionManager.CanDrawGrid(),
 		.UndosAvailable = m_VersionManager.UndosAvailable(),
 		.RedosAvailable = m_VersionManager.RedosAvailable(),
-		.HasUnsavedChanges = !m_VersionManager.IsSaved()
+		.HasUnsavedChanges = !m_VersionManager.IsSaved(),
+		.GridBounded = m_Grid.Bounded()
     };
 }
 
-gol::SimulationState gol::SimulationEditor::SimulationUpdate(const GraphicsHandlerArgs& args)
+gol::SimulationState gol::SimulationEditor::SimulationUpdate()
 {
-    GL_DEBUG(auto elapsed = (glfwGetTime() - m_LastTime) * 1000);
-    if (elapsed >= m_TickDelayMs)
+    if (!m_Worker->HoldsGrid())
     {
-        GL_DEBUG(m_LastTime = glfwGetTime());
-        m_Grid.Update();
-        if (m_Grid.Dead() && !m_SelectionManager.GridAlive())
-            return SimulationState::Empty;
+        m_Worker->Start(TakeGrid());
+        m_Worker->AcquireLatest();
+    }
+
+    if (m_Worker->Latest().Population == 0 && !m_SelectionManager.GridAlive())
+    {
+        m_Worker->Pause();
+        return SimulationState::Empty;
     }
-    m_Graphics.DrawGrid({ 0, 0 }, m_Grid.Data(), args);
     return SimulationState::Simulation;
 }
 
-gol::SimulationState gol::SimulationEditor::PaintUpdate(const GraphicsHandlerArgs& args)
+void gol::SimulationEditor::DrawLatestGeneration(const GraphicsHandlerArgs& args)
 {
-    auto gridPos = CursorGridPos();
-    
-    m_Graphics.DrawGrid({ 0, 0 }, m_Grid.Data(), args);
-    if (m_SelectionManager.CanDrawGrid())
-        m_Graphics.DrawGrid(m_SelectionManager.SelectionBounds().UpperLeft(), m_SelectionManager.GridData(), args);
-    if (m_SelectionManager.CanDrawGrid())
-        m_Graphics.DrawSelection(m_SelectionManager.SelectionBounds(), args);
+    // The snapshot is sorted by X, so the columns are a slice of it and only the rows are filtered
+    const auto region = VisibleGridRegion();
+    const auto inRows = [&region](const Vec2& cell) { return cell.Y >= region.Y && cell.Y < region.Y + region.Height; };
+    auto cells = m_Worker->Latest().CellsInColumns(region.X, region.X + region.Width) | std::views::filter(inRows);
+    m_Graphics.DrawGrid({ 0, 0 }, cells, args);
+}
 
+gol::SimulationState gol::SimulationEditor::PaintUpdate()
+{
+    auto gridPos = CursorGridPos();
     if (gridPos)
-    {
-        if (m_SelectionManager.CanDrawSelection())
-            m_Graphics.DrawSelection(m_SelectionManager.SelectionBounds(), args);
         UpdateMouseState(*gridPos);
-    }
     else
-    {
         m_SelectionManager.TryResetSelection();
-    }
     m_LeftDeltaLast = ImGui::GetMouseDragDelta(ImGuiMouseButton_Left);
 
     return (m_Grid.Dead() && !m_SelectionManager.GridAlive())
@@ -164,17 +203,41 @@ gol::SimulationState gol::SimulationEditor::PaintUpdate(const GraphicsHandlerArg
         : SimulationState::Paint;
 }
 
-gol::SimulationState gol::SimulationEditor::PauseUpdate(const GraphicsHandlerArgs& args)
+gol::SimulationState gol::SimulationEditor::PauseUpdate()
 {
     auto gridPos = CursorGridPos();
     if (gridPos)
         m_VersionManager.TryPushChange(m_SelectionManager.UpdateSelectionArea(m_Grid, *gridPos).Change);
-    m_Graphics.DrawGrid({ 0, 0 }, m_Grid.Data(), args);
-    if (m_SelectionManager.CanDrawSelection())
-        m_Graphics.DrawSelection(m_SelectionManager.SelectionBounds(), args);
+    return SimulationState::Paused;
+}
+
+void gol::SimulationEditor::Render(const GraphicsHandlerArgs& args)
+{
+    m_Graphics.RescaleFrameBuffer(WindowBounds(), ViewportBounds());
+    m_Graphics.ClearBackground(args);
+    if (m_Worker->HoldsGrid())
+    {
+        DrawLatestGeneration(args);
+        return;
+    }
+
+    m_Graphics.DrawGrid({ 0, 0 }, m_Grid.CellsIn(VisibleGridRegion()), args);
+    if (m_State == SimulationState::Paused)
+    {
+        if (m_SelectionManager.CanDrawSelection())
+            m_Graphics.DrawSelection(m_SelectionManager.SelectionBounds(), args);
+        if (m_SelectionManager.CanDrawGrid())
+            m_Graphics.DrawGrid(m_SelectionManager.SelectionBounds().UpperLeft(), m_SelectionManager.GridData(), args);
+        return;
+    }
+
     if (m_SelectionManager.CanDrawGrid())
+    {
         m_Graphics.DrawGrid(m_SelectionManager.SelectionBounds().UpperLeft(), m_SelectionManager.GridData(), args);
-    return SimulationState::Paused;
+        m_Graphics.DrawSelection(m_SelectionManager.SelectionBounds(), args);
+    }
+    if (m_SelectionManager.CanDrawSelection() && CursorGridPos())
+        m_Graphics.DrawSelection(m_SelectionManager.SelectionBounds(), args);
 }
 
 gol::SimulationEditor::DisplayResult gol::SimulationEditor::DisplaySimulation(bool grabFocus)
@@ -220,8 +283,16 @@ gol::SimulationEditor::DisplayResult gol::SimulationEditor::DisplaySimulation(bo
 
     splitter.SetCurrentChannel(ImGui::GetWindowDrawList(), 1);
     ImGui::SetCursorPos(ImGui::GetWindowContentRegionMin());
-    ImGui::Text("%s", std::format("Generation: {}", m_Grid.Generation()).c_str());
-    ImGui::Text("%s", std::format("Population: {}", m_Grid.Population() + m_SelectionManager.SelectedPopulation()).c_str());
+    const auto* latest = m_Worker->HoldsGrid() ? &m_Worker->Latest() : nullptr;
+    const auto generation = latest ? latest->Generation : m_Grid.Generation();
+    const auto population = latest ? latest->Population : m_Grid.Population();
+    const auto period = latest ? latest->Period : m_Grid.DetectedPeriod();
+    ImGui::Text("%s", std::format("Generation: {}", generation).c_str());
+    ImGui::Text("%s", std::format("Population: {}", population + m_SelectionManager.SelectedPopulation()).c_str());
+    if (period)
+        ImGui::Text("%s", std::format("Period {} detected", *period).c_str());
+    if (latest && m_State == SimulationState::Simulation)
+        ImGui::Text("%s", std::format("Speed: {:.0f} generations/s", latest->GenerationsPerSecond).c_str());
 
     if (m_SelectionManager.CanDrawSelection())
     {
@@ -272,11 +343,54 @@ std::optional<gol::Vec2> gol::SimulationEditor::ConvertToGridPos(Vec2F screenPos
     return result;
 }
 
+gol::Rect gol::SimulationEditor::VisibleGridRegion() const
+{
+    const auto bounds = ViewportBounds();
+    const auto cellSize = glm::vec2 { DefaultCellWidth, DefaultCellHeight };
+    const auto corner = m_Graphics.Camera.ScreenToWorldPos(
+        { static_cast<float>(bounds.X), static_cast<float>(bounds.Y) }, bounds) / cellSize;
+    const auto opposite = m_Graphics.Camera.ScreenToWorldPos(
+        { static_cast<float>(bounds.X + bounds.Width), static_cast<float>(bounds.Y + bounds.Height) }, bounds) / cellSize;
+
+    // Rounding outwards keeps cells that are only partly on screen
+    static constexpr auto limit = static_cast<double>(std::numeric_limits<int32_t>::max() / 2);
+    const auto toCell = [](double value) { return static_cast<int32_t>(std::clamp(value, -limit, limit)); };
+    const auto left = toCell(std::floor(std::min(corner.x, opposite.x)));
+    const auto top = toCell(std::floor(std::min(corner.y, opposite.y)));
+    const auto right = toCell(std::ceil(std::max(corner.x, opposite.x)));
+    const auto bottom = toCell(std::ceil(std::max(corner.y, opposite.y)));
+    return { left, top, right - left + 1, bottom - top + 1 };
+}
+
 std::optional<gol::Vec2> gol::SimulationEditor::CursorGridPos()
 {
     return ConvertToGridPos(ImGui::GetMousePos());
 }
 
+gol::GameGrid gol::SimulationEditor::TakeGrid()
+{
+    GameGrid placeholder { m_Grid.Size(), m_Grid.Algorithm() };
+    placeholder.SetRule(m_Grid.Rule());
+    return std::exchange(m_Grid, std::move(placeholder));
+}
+
+void gol::SimulationEditor::ReclaimGrid()
+{
+    if (!m_Worker->HoldsGrid())
+        return;
+
+    auto grid = m_Worker->TryReclaim();
+    if (!grid)
+        return;
+
+    m_Grid = std::move(*grid);
+    m_Dirty = true;
+    if (m_State == SimulationState::Paused && m_Grid.Dead())
+        m_State = SimulationState::Empty;
+    if (m_DeferredAction)
+        m_State = UpdateState(*std::exchange(m_DeferredAction, std::nullopt));
+}
+
 void gol::SimulationEditor::UpdateVersion(const SimulationControlResult& args)
 {
     if (ImGui::IsMouseDown(ImGuiMouseButton_Left))
@@ -308,6 +422,7 @@ gol::SimulationState gol::SimulationEditor::UpdateState(const SimulationControlR
             m_InitialGrid = m_Grid;
             return SimulationState::Simulation;
         case Clear:
+        {
             m_VersionManager.TryPushChange(m_SelectionManager.Deselect(m_Grid));
             m_VersionManager.PushChange({
                 .Action = GameAction::Clear,
@@ -315,8 +430,11 @@ gol::SimulationState gol::SimulationEditor::UpdateState(const SimulationControlR
                 .CellsInserted = {},
                 .CellsDeleted = m_Grid.Data()
             });
-            m_Grid = GameGrid { m_Grid.Size() };
+            const auto rule = m_Grid.Rule();
+            m_Grid = GameGrid { m_Grid.Size(), m_Grid.Algorithm() };
+            m_Grid.SetRule(rule);
             return SimulationState::Paint;
+        }
         case Reset:
             m_SelectionManager.Deselect(m_Grid);
             m_Grid = m_InitialGrid;
@@ -334,9 +452,8 @@ gol::SimulationState gol::SimulationEditor::UpdateState(const SimulationControlR
             m_SelectionManager.Deselect(m_Grid);
             if (result.State == SimulationState::Paint)
                 m_InitialGrid = m_Grid;
-            for (int32_t i = 0; i < *result.StepCount; i++)
-                m_Grid.Update();
-            return m_Grid.Dead() ? SimulationState::Empty : SimulationState::Paused;
+            m_Worker->Step(TakeGrid(), *result.StepCount);
+            return SimulationState::Paused;
         }
     }
 
@@ -418,7 +535,7 @@ void gol::SimulationEditor::LoadFile(const gol::SimulationControlResult& result)
 {
     m_VersionManager.TryPushChange(m_SelectionManager.Deselect(m_Grid));
 
-    auto loadResult = m_SelectionManager.Load(*result.FilePath);
+    auto loadResult = m_SelectionManager.Load(m_Grid, *result.FilePath);
     if (loadResult)
         m_VersionManager.PushChange(*loadResult);
     else
@@ -446,6 +563,7 @@ gol::SimulationState gol::SimulationEditor::ResizeGrid(const gol::SimulationCont
     });
 
     m_Grid = GameGrid(std::move(m_Grid), *result.NewDimensions);
+    m_Grid.SetAlgorithm(GameGrid::PreferredAlgorithm(m_Grid.Size()));
     if (m_SelectionManager.CanDrawSelection())
     {
         auto selection = m_SelectionManager.SelectionBounds();
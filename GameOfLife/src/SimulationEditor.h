@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <glm/glm.hpp>
+#include <memory>
 #include <optional>
 
 #include "EditorResult.h"
@@ -14,6 +15,7 @@
 #include "PresetSelectionResult.h"
 #include "SelectionManager.h"
 #include "SimulationControlResult.h"
+#include "SimulationWorker.h"
 #include "VersionManager.h"
 #include "WarnWindow.h"
 
@@ -35,6 +37,9 @@ namespace gol
 		
 		uint32_t EditorID() const { return m_EditorID; }
 		bool IsSaved() const;
+
+		// True while the worker holds the grid, so there are generations to show or a grid to take back
+		bool IsSimulating() const { return m_Worker->HoldsGrid(); }
 		bool operator==(const SimulationEditor& other) const;
 	private:
 		struct DisplayResult
@@ -43,13 +48,33 @@ namespace gol
 			bool Selected = false;
 			bool Closing = false;
 		};
+
+		// What the framebuffer depends on besides the cells and the selection
+		struct ViewState
+		{
+			Rect ViewportBounds;
+			GraphicsCamera Camera;
+			bool ShowGridLines = false;
+
+			bool operator==(const ViewState&) const = default;
+		};
 	private:
-		SimulationState SimulationUpdate(const GraphicsHandlerArgs& args);
-		SimulationState PaintUpdate(const GraphicsHandlerArgs& args);
-		SimulationState PauseUpdate(const GraphicsHandlerArgs& args);
+		SimulationState SimulationUpdate();
+		SimulationState PaintUpdate();
+		SimulationState PauseUpdate();
+
+		// Redraws the framebuffer, which is otherwise left showing the last frame drawn
+		void Render(const GraphicsHandlerArgs& args);
+		void DrawLatestGeneration(const GraphicsHandlerArgs& args);
 
 		void UpdateVersion(const SimulationControlResult& args);
 
+		// Hands m_Grid to the worker, leaving an empty grid of the same size and rule in its place
+		GameGrid TakeGrid();
+
+		// Takes the grid back once the worker has let go of it, then runs the action that was waiting for it
+		void ReclaimGrid();
+
 		DisplayResult DisplaySimulation(bool grabFocus);
 
 		SimulationState UpdateState(const SimulationControlResult& action);
@@ -60,6 +85,9 @@ namespace gol
 		std::optional<Vec2> CursorGridPos();
 		std::optional<Vec2> ConvertToGridPos(Vec2F screenPos);
 
+		// Grid cells the camera can currently see
+		Rect VisibleGridRegion() const;
+
 		void UpdateMouseState(Vec2 gridPos);
 		void FillCells();
 		void UpdateDragState();
@@ -71,15 +99,24 @@ namespace gol
 
 		SimulationState m_State = SimulationState::Paint;
 
+		// Stale while the worker holds the grid, when the worker's latest generation is shown instead
 		GameGrid m_Grid;
 		GameGrid m_InitialGrid;
 
+		// Held by pointer so editors stay movable
+		std::unique_ptr<SimulationWorker> m_Worker = std::make_unique<SimulationWorker>();
+		std::optional<SimulationControlResult> m_DeferredAction;
+
 		SelectionManager m_SelectionManager;
 		VersionManager m_VersionManager;
 
 		GraphicsHandler m_Graphics;
 		RectF m_WindowBounds;
 
+		// Set by anything that changes the cells, the selection or the generation shown
+		bool m_Dirty = true;
+		ViewState m_LastView;
+
 		ErrorWindow m_FileErrorWindow;
 		WarnWindow m_PasteWarning;
 		
@@ -90,7 +127,6 @@ namespace gol
 		Vec2F m_RightDeltaLast;
 		
 		double m_TickDelayMs = DefaultTickDelayMs;
-		double m_LastTime = 0;
 
 		EditorMode m_EditorMode = EditorMode::None;
 	};